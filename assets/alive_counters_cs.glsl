@@ -0,0 +1,32 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+
+layout(local_size_x = 1) in;
+
+// Set after the update pass, which has moved every surviving particle to the next list.
+uniform bool finish;
+// Anything past this has been killed by alive_trim_cs.
+uniform uint maxAlive;
+
+void main() {
+  if (finish) {
+    aliveCount = aliveNextCount;
+    aliveNextCount = 0u;
+  }
+  aliveCount = min(aliveCount, maxAlive);
+
+  aliveDispatch[0] = (aliveCount + WORK_GROUP_SIZE_X - 1u) / WORK_GROUP_SIZE_X;
+  aliveDispatch[1] = 1u;
+  aliveDispatch[2] = 1u;
+
+  aliveDraw[0] = aliveCount;
+  aliveDraw[1] = 1u;
+  aliveDraw[2] = 0u;
+  aliveDraw[3] = 0u;
+
+  aliveQuadDraw[0] = 4u;
+  aliveQuadDraw[1] = aliveCount;
+  aliveQuadDraw[2] = 0u;
+  aliveQuadDraw[3] = 0u;
+}
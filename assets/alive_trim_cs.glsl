@@ -0,0 +1,24 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+
+uniform uint maxAlive;
+
+// NOTE(ryan): Kills the tail of the alive list past maxAlive. alive_counters_cs then drops it from
+// the list by clamping aliveCount, so the survivors stay packed at the front.
+void main() {
+  uint i = gl_GlobalInvocationID.x;
+  if (i < maxAlive || i >= aliveCount) return;
+
+  uint id = aliveList[i];
+  particle[id].scale = 0.0;
+  particle[id].color = vec4(0.0);
+  killParticle(id);
+}
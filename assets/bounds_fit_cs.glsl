@@ -0,0 +1,55 @@
+#version 430 core
+
+#include "utils/volume_bounds.glsl"
+
+layout(local_size_x = 1) in;
+
+uniform uvec3 volumeRes;
+uniform float margin;
+uniform float shrinkThreshold;
+uniform float minSize;
+
+void main() {
+  uvec3 rMin = reduceMin.xyz, rMax = reduceMax.xyz;
+
+  // Start the next reduction from an empty box whatever happens below.
+  reduceMin = uvec4(0xffffffffu);
+  reduceMax = uvec4(0u);
+
+  // No live particles.
+  if (any(greaterThan(rMin, rMax))) return;
+
+  vec3 aabbMin = orderedBitsToFloat(rMin);
+  vec3 aabbMax = orderedBitsToFloat(rMax);
+
+  // NOTE(ryan): Hysteresis. Only refit when particles escape the volume or the cloud has shrunk
+  // well inside it, otherwise the grid would shift under the particles every frame.
+  vec3 boundsMin = fitBoundsMin.xyz, boundsMax = fitBoundsMax.xyz;
+  float size = boundsMax.x - boundsMin.x;
+  float extent = max(max(aabbMax.x - aabbMin.x, aabbMax.y - aabbMin.y), aabbMax.z - aabbMin.z);
+  float fitSize = max(extent * (1.0 + 2.0 * margin), minSize);
+
+  bool escaped = any(lessThan(aabbMin, boundsMin)) || any(greaterThan(aabbMax, boundsMax));
+  bool shrunk = fitSize < shrinkThreshold * size;
+  if (!escaped && !shrunk) return;
+
+  // Cubic, so volume cells stay isotropic.
+  vec3 centre = 0.5 * (aabbMin + aabbMax);
+  boundsMin = centre - vec3(0.5 * fitSize);
+  boundsMax = centre + vec3(0.5 * fitSize);
+
+  float oneOverSize = 1.0 / fitSize;
+  mat4 unitMtx = mat4(vec4(oneOverSize, 0.0, 0.0, 0.0),
+                      vec4(0.0, oneOverSize, 0.0, 0.0),
+                      vec4(0.0, 0.0, oneOverSize, 0.0),
+                      vec4(-boundsMin * oneOverSize, 1.0));
+  mat4 volumeScale = mat4(1.0);
+  volumeScale[0][0] = float(volumeRes.x);
+  volumeScale[1][1] = float(volumeRes.y);
+  volumeScale[2][2] = float(volumeRes.z);
+
+  fitWorldToUnitVolumeMtx = unitMtx;
+  fitWorldToVolumeMtx = volumeScale * unitMtx;
+  fitBoundsMin = vec4(boundsMin, 0.0);
+  fitBoundsMax = vec4(boundsMax, 0.0);
+}
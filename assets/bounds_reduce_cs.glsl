@@ -0,0 +1,47 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/particle.glsl"
+#include "utils/volume_bounds.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+
+shared uvec3 groupMin[WORK_GROUP_SIZE_X];
+shared uvec3 groupMax[WORK_GROUP_SIZE_X];
+
+void main() {
+  uint lid = gl_LocalInvocationID.x;
+
+  // Padding invocations contribute an empty box.
+  uint id;
+  if (getAliveParticle(id)) {
+    uvec3 bits = orderedFloatBits(particle[id].position);
+    groupMin[lid] = bits;
+    groupMax[lid] = bits;
+  } else {
+    groupMin[lid] = uvec3(0xffffffffu);
+    groupMax[lid] = uvec3(0u);
+  }
+  barrier();
+
+  for (uint stride = WORK_GROUP_SIZE_X / 2; stride > 0; stride >>= 1) {
+    if (lid < stride) {
+      groupMin[lid] = min(groupMin[lid], groupMin[lid + stride]);
+      groupMax[lid] = max(groupMax[lid], groupMax[lid + stride]);
+    }
+    barrier();
+  }
+
+  if (lid == 0 && groupMax[0].x != 0u) {
+    atomicMin(reduceMin.x, groupMin[0].x);
+    atomicMin(reduceMin.y, groupMin[0].y);
+    atomicMin(reduceMin.z, groupMin[0].z);
+    atomicMax(reduceMax.x, groupMax[0].x);
+    atomicMax(reduceMax.y, groupMax[0].y);
+    atomicMax(reduceMax.z, groupMax[0].z);
+  }
+}
@@ -1,5 +1,7 @@
 #version 430 core
 
+#include "utils/alive_list.glsl"
+#include "utils/frame_constants.glsl"
 #include "utils/particle.glsl"
 
 layout(local_size_x = WORK_GROUP_SIZE_X) in;
@@ -9,8 +11,6 @@ layout(std140, binding = 0) buffer ParticleBuffer {
 };
 layout(r32ui, binding = 1) uniform uimage3D volumeDensity;
 
-uniform mat4 worldToVolumeMtx;
-
 const uint kMaxDensityPerParticle = 1024;
 
 ivec3 worldToVolumeCoord(in vec3 pos) {
@@ -18,7 +18,8 @@ ivec3 worldToVolumeCoord(in vec3 pos) {
 }
 
 void main() {
-  uint id = gl_GlobalInvocationID.x;
+  uint id;
+  if (!getAliveParticle(id)) return;
   ivec3 coord = worldToVolumeCoord(particle[id].position);
   imageAtomicAdd(volumeDensity, coord, 1);
 }
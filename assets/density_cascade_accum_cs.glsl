@@ -0,0 +1,25 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/density_cascades.glsl"
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+layout(r32ui, binding = 1) uniform uimage3D cascadeDensityImg;
+
+uniform int cascadeIndex;
+
+void main() {
+  uint id;
+  if (!getAliveParticle(id)) return;
+
+  ivec3 cell = ivec3(floor(particle[id].position * cascadeOneOverCellSize[cascadeIndex]));
+  ivec3 local = cell - cascadeOriginCell[cascadeIndex];
+  if (any(lessThan(local, ivec3(0))) || any(greaterThanEqual(local, ivec3(cascadeRes)))) return;
+
+  imageAtomicAdd(cascadeDensityImg, cascadeTexel(cell), 1u);
+}
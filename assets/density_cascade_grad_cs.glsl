@@ -0,0 +1,24 @@
+#version 430 core
+
+#include "utils/density_cascades.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_XYZ, local_size_y = WORK_GROUP_SIZE_XYZ,
+       local_size_z = WORK_GROUP_SIZE_XYZ) in;
+
+layout(r32ui, binding = 0) readonly uniform uimage3D cascadeDensityImg;
+layout(rgba16f, binding = 1) writeonly uniform image3D cascadeGradImg;
+
+float density(ivec3 texel) {
+  return float(imageLoad(cascadeDensityImg, cascadeTexel(texel)).r);
+}
+
+// Same central differences as density_grad_cs.glsl, except neighbours wrap toroidally.
+void main() {
+  ivec3 c = ivec3(gl_GlobalInvocationID);
+
+  vec3 grad = vec3(density(c + ivec3(1, 0, 0)) - density(c - ivec3(1, 0, 0)),
+                   density(c + ivec3(0, 1, 0)) - density(c - ivec3(0, 1, 0)),
+                   density(c + ivec3(0, 0, 1)) - density(c - ivec3(0, 0, 1)));
+
+  imageStore(cascadeGradImg, c, vec4(grad, 0.0));
+}
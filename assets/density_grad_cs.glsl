@@ -1,13 +1,13 @@
 #version 430 core
 
+#include "utils/frame_constants.glsl"
+
 layout(local_size_x = WORK_GROUP_SIZE_XYZ, local_size_y = WORK_GROUP_SIZE_XYZ,
        local_size_z = WORK_GROUP_SIZE_XYZ) in;
 
 layout(r32ui, binding = 0) readonly uniform uimage3D densityImg;
 layout(rgba16f, binding = 1) writeonly uniform image3D gradientImg;
 
-uniform uvec3 volumeRes;
-
 ivec3 clampToVol(in ivec3 c) {
   return clamp(c, ivec3(0), ivec3(volumeRes - 1));
 }
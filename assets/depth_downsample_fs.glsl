@@ -0,0 +1,19 @@
+#version 430 core
+
+uniform sampler2D sceneDepthTex;
+uniform int downsample;
+
+// NOTE(ryan): Keeps the farthest depth of each block, so a particle shows at low resolution if it's
+// in front of any of the pixels it covers. The upsample sorts out which pixels actually get it.
+void main() {
+  ivec2 base = ivec2(gl_FragCoord.xy) * downsample;
+  ivec2 maxCoord = textureSize(sceneDepthTex, 0) - 1;
+
+  float depth = 0.0;
+  for (int y = 0; y < downsample; ++y) {
+    for (int x = 0; x < downsample; ++x) {
+      depth = max(depth, texelFetch(sceneDepthTex, min(base + ivec2(x, y), maxCoord), 0).r);
+    }
+  }
+  gl_FragDepth = depth;
+}
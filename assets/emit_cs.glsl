@@ -0,0 +1,78 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/emitter.glsl"
+#include "utils/frame_constants.glsl"
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+layout(std140, binding = 1) buffer ParticlePrevBuffer {
+  Particle particlePrev[];
+};
+
+uniform uint emitterCount, spawnCount;
+// Budget on live particles. Checked loosely, alive_trim_cs takes off any overshoot.
+uniform uint maxAlive;
+// Spawns start at a random point in their lifetime, see ParticleEmitters::prewarm.
+uniform bool prewarm;
+
+const float kTwoPi = 6.2831853;
+
+// Integer hash by Chris Wellons (lowbias32).
+uint hash(uint x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+float rand(inout uint state) {
+  state = hash(state);
+  return float(state >> 8) / 16777216.0;
+}
+
+vec3 randVec3(inout uint state) {
+  float phi = rand(state) * kTwoPi;
+  float costheta = mix(-1.0, 1.0, rand(state));
+  float rho = sqrt(1.0 - costheta * costheta);
+  return vec3(rho * cos(phi), rho * sin(phi), costheta);
+}
+
+void main() {
+  uint i = gl_GlobalInvocationID.x;
+  if (i >= spawnCount) return;
+
+  // Emitters are few, a linear search over the spawn ranges is fine.
+  uint e = 0u;
+  while (e + 1u < emitterCount && i >= emitter[e + 1u].spawnOffset) ++e;
+
+  if (atomicAdd(aliveCount, 0u) >= maxAlive) return;
+
+  int dead = atomicAdd(deadCount, -1);
+  if (dead <= 0) {
+    // Pool exhausted, the spawn is dropped.
+    atomicAdd(deadCount, 1);
+    return;
+  }
+  uint id = deadList[dead - 1];
+
+  uint state = hash(i ^ hash(frameId));
+  vec3 pos = emitter[e].position +
+             randVec3(state) * mix(emitter[e].radiusMin, emitter[e].radiusMax, rand(state));
+
+  particle[id].position = pos;
+  particle[id].scale = mix(emitter[e].scaleMin, emitter[e].scaleMax, rand(state));
+  particle[id].color = emitter[e].color;
+  particlePrev[id] = particle[id];
+  particlePrev[id].position = pos - emitter[e].velocity * timeDelta;
+
+  float age = prewarm ? rand(state) * emitter[e].lifetime : 0.0;
+  particleLife[id] = ParticleLife(age, emitter[e].lifetime, e, emitter[e].flags);
+  aliveList[atomicAdd(aliveCount, 1u)] = id;
+}
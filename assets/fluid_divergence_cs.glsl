@@ -0,0 +1,27 @@
+#version 430 core
+
+#include "utils/frame_constants.glsl"
+#include "utils/fluid_grid.glsl"
+
+layout(rgba32f, binding = 0) readonly uniform image3D velocityImg;
+layout(r32f, binding = 2) writeonly uniform image3D divergenceImg;
+
+void main() {
+  ivec3 c = ivec3(gl_GlobalInvocationID);
+  vec4 v = imageLoad(velocityImg, c);
+
+  float div = 0.0;
+  if (v.w > 0.0) {
+    for (int axis = 0; axis < 3; ++axis) {
+      ivec3 o = kNeighbourOffsets[axis * 2];
+      // Walls don't move, air takes on the velocity of the fluid next to it.
+      vec4 vp = isInside(c + o) ? imageLoad(velocityImg, c + o) : vec4(0.0, 0.0, 0.0, 1.0);
+      vec4 vn = isInside(c - o) ? imageLoad(velocityImg, c - o) : vec4(0.0, 0.0, 0.0, 1.0);
+      float up = vp.w > 0.0 ? vp[axis] : v[axis];
+      float un = vn.w > 0.0 ? vn[axis] : v[axis];
+      div += 0.5 * (up - un);
+    }
+  }
+
+  imageStore(divergenceImg, c, vec4(div));
+}
@@ -0,0 +1,26 @@
+#version 430 core
+
+#include "utils/frame_constants.glsl"
+#include "utils/fluid_grid.glsl"
+
+layout(std430, binding = 12) readonly buffer FluidAccumBuffer {
+  int fluidAccum[];
+};
+
+layout(rgba32f, binding = 0) writeonly uniform image3D velocityImg;
+layout(rgba32f, binding = 1) writeonly uniform image3D velocityPrevImg;
+
+uniform float fixedPointScale;
+uniform float minWeight;
+
+void main() {
+  ivec3 c = ivec3(gl_GlobalInvocationID);
+  uint i = 4u * ((uint(c.z) * volumeRes.y + uint(c.y)) * volumeRes.x + uint(c.x));
+
+  vec4 m = vec4(fluidAccum[i + 0u], fluidAccum[i + 1u], fluidAccum[i + 2u], fluidAccum[i + 3u]) /
+           fixedPointScale;
+  vec4 v = m.w > minWeight ? vec4(m.xyz / m.w, m.w) : vec4(0.0);
+
+  imageStore(velocityImg, c, v);
+  imageStore(velocityPrevImg, c, v);
+}
@@ -0,0 +1,50 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/frame_constants.glsl"
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+layout(std140, binding = 1) buffer ParticlePrevBuffer {
+  Particle particlePrev[];
+};
+
+// Momentum xyz and weight per cell in fixed point, there are no float atomics in core GL.
+layout(std430, binding = 12) buffer FluidAccumBuffer {
+  int fluidAccum[];
+};
+
+uniform float fixedPointScale;
+
+void splat(ivec3 c, float w, vec3 vel) {
+  if (any(lessThan(c, ivec3(0))) || any(greaterThanEqual(c, ivec3(volumeRes)))) return;
+
+  uint i = 4u * ((uint(c.z) * volumeRes.y + uint(c.y)) * volumeRes.x + uint(c.x));
+  atomicAdd(fluidAccum[i + 0u], int(round(vel.x * w * fixedPointScale)));
+  atomicAdd(fluidAccum[i + 1u], int(round(vel.y * w * fixedPointScale)));
+  atomicAdd(fluidAccum[i + 2u], int(round(vel.z * w * fixedPointScale)));
+  atomicAdd(fluidAccum[i + 3u], int(round(w * fixedPointScale)));
+}
+
+void main() {
+  uint id;
+  if (!getAliveParticle(id)) return;
+
+  vec3 pos = particle[id].position;
+  vec3 vel = pos - particlePrev[id].position;
+
+  // Trilinear weights to the 8 surrounding cell centres.
+  vec3 g = vec3(worldToVolumeMtx * vec4(pos, 1.0)) - 0.5;
+  ivec3 c0 = ivec3(floor(g));
+  vec3 f = g - vec3(c0);
+
+  for (int i = 0; i < 8; ++i) {
+    ivec3 o = ivec3(i & 1, (i >> 1) & 1, i >> 2);
+    vec3 w = mix(1.0 - f, f, vec3(o));
+    splat(c0 + o, w.x * w.y * w.z, vel);
+  }
+}
@@ -0,0 +1,35 @@
+#version 430 core
+
+#include "utils/frame_constants.glsl"
+#include "utils/fluid_grid.glsl"
+
+layout(rgba32f, binding = 0) readonly uniform image3D velocityImg;
+layout(r32f, binding = 2) readonly uniform image3D divergenceImg;
+layout(r32f, binding = 3) uniform image3D pressureImg;
+
+// Red-black Gauss-Seidel, each dispatch updates the cells with (x + y + z) % 2 == parity.
+uniform int parity;
+
+void main() {
+  ivec3 c = ivec3(gl_GlobalInvocationID);
+  if (((c.x + c.y + c.z) & 1) != parity) return;
+
+  if (imageLoad(velocityImg, c).w <= 0.0) {
+    imageStore(pressureImg, c, vec4(0.0));
+    return;
+  }
+
+  // Solve sum(p_n) - n * p = div. Wall neighbours drop out of the stencil, air neighbours are
+  // zero pressure.
+  float sum = 0.0;
+  float n = 0.0;
+  for (int i = 0; i < 6; ++i) {
+    ivec3 cn = c + kNeighbourOffsets[i];
+    if (!isInside(cn)) continue;
+    sum += imageLoad(pressureImg, cn).r;
+    n += 1.0;
+  }
+
+  float div = imageLoad(divergenceImg, c).r;
+  imageStore(pressureImg, c, vec4((sum - div) / n));
+}
@@ -0,0 +1,25 @@
+#version 430 core
+
+#include "utils/frame_constants.glsl"
+#include "utils/fluid_grid.glsl"
+
+layout(rgba32f, binding = 0) uniform image3D velocityImg;
+layout(r32f, binding = 3) readonly uniform image3D pressureImg;
+
+void main() {
+  ivec3 c = ivec3(gl_GlobalInvocationID);
+  vec4 v = imageLoad(velocityImg, c);
+  if (v.w <= 0.0) return;
+
+  float p = imageLoad(pressureImg, c).r;
+  vec3 grad;
+  for (int axis = 0; axis < 3; ++axis) {
+    ivec3 o = kNeighbourOffsets[axis * 2];
+    // No pressure gradient into walls.
+    float pp = isInside(c + o) ? imageLoad(pressureImg, c + o).r : p;
+    float pn = isInside(c - o) ? imageLoad(pressureImg, c - o).r : p;
+    grad[axis] = 0.5 * (pp - pn);
+  }
+
+  imageStore(velocityImg, c, vec4(v.xyz - grad, v.w));
+}
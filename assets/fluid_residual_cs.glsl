@@ -0,0 +1,31 @@
+#version 430 core
+
+#include "utils/frame_constants.glsl"
+#include "utils/fluid_grid.glsl"
+
+layout(rgba32f, binding = 0) readonly uniform image3D velocityImg;
+layout(r32f, binding = 2) readonly uniform image3D divergenceImg;
+layout(r32f, binding = 3) readonly uniform image3D pressureImg;
+
+// Max absolute residual. Non-negative floats order the same as their bits.
+layout(std430, binding = 13) buffer FluidResidualBuffer {
+  uint maxResidual;
+};
+
+void main() {
+  ivec3 c = ivec3(gl_GlobalInvocationID);
+  if (imageLoad(velocityImg, c).w <= 0.0) return;
+
+  float p = imageLoad(pressureImg, c).r;
+  float sum = 0.0;
+  float n = 0.0;
+  for (int i = 0; i < 6; ++i) {
+    ivec3 cn = c + kNeighbourOffsets[i];
+    if (!isInside(cn)) continue;
+    sum += imageLoad(pressureImg, cn).r;
+    n += 1.0;
+  }
+
+  float r = abs(imageLoad(divergenceImg, c).r - (sum - n * p));
+  atomicMax(maxResidual, floatBitsToUint(r));
+}
@@ -0,0 +1,31 @@
+#version 430 core
+
+#include "utils/force_fields.glsl"
+#include "utils/frame_constants.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+void main() {
+  const uint res = uint(kForceFieldBinRes);
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= res * res * res) return;
+
+  ivec3 cell = ivec3(uvec3(index % res, (index / res) % res, index / (res * res)));
+
+  // Edge cells reach out to infinity, they're where particles outside the volume look.
+  vec3 cellSize = (volumeBoundsMax - volumeBoundsMin) / float(kForceFieldBinRes);
+  vec3 cellMin = volumeBoundsMin + vec3(cell) * cellSize;
+  vec3 cellMax = cellMin + cellSize;
+  float infinity = uintBitsToFloat(0x7f800000u);
+  cellMin = mix(cellMin, vec3(-infinity), equal(cell, ivec3(0)));
+  cellMax = mix(cellMax, vec3(infinity), equal(cell, ivec3(kForceFieldBinRes - 1)));
+
+  uvec2 mask = uvec2(0u);
+  for (uint i = 0u; i < forceFieldCount; ++i) {
+    ForceField f = forceField[i];
+    if (all(lessThanEqual(f.boundsMin, cellMax)) && all(greaterThanEqual(f.boundsMax, cellMin))) {
+      mask[i / 32u] |= 1u << (i % 32u);
+    }
+  }
+  forceFieldBin[index] = mask;
+}
@@ -0,0 +1,7 @@
+#version 430 core
+
+// One triangle covering the viewport, drawn as 3 vertices with no attributes.
+void main() {
+  vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,30 @@
+#version 430 core
+
+#include "utils/neighbour_grid.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+// RadixSort's scan output, see RadixSort::scan.
+layout(std430, binding = 1) readonly buffer ScanBuffer {
+  uvec4 scanBuf[];
+};
+layout(std430, binding = 2) readonly buffer BlockSumBuffer {
+  uvec4 blockSum[];
+};
+
+layout(std430, binding = 10) readonly buffer GridCountBuffer {
+  uvec4 gridCount[];
+};
+
+uniform uint cellCount, scanBlockSize;
+
+void main() {
+  uint cell = gl_GlobalInvocationID.x;
+  if (cell >= cellCount) return;
+
+  uint block = cell / scanBlockSize;
+  uint end = scanBuf[cell].x + (block > 0u ? blockSum[block - 1u].x : 0u);
+  uint count = gridCount[cell].x;
+
+  gridCellRange[cell] = uvec2(end - count, count);
+}
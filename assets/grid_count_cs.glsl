@@ -0,0 +1,34 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/neighbour_grid.glsl"
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+
+// Only .x is used, RadixSort's scan works on uvec4s.
+layout(std430, binding = 10) buffer GridCountBuffer {
+  uvec4 gridCount[];
+};
+// Per particle: cell, index within the cell.
+layout(std430, binding = 11) buffer GridSlotBuffer {
+  uvec2 gridSlot[];
+};
+
+const uint kNoCell = 0xffffffffu;
+
+void main() {
+  uint id;
+  if (!getAliveParticle(id)) return;
+
+  uint cell;
+  if (gridCellIndex(gridCellCoord(particle[id].position), cell)) {
+    gridSlot[id] = uvec2(cell, atomicAdd(gridCount[cell].x, 1u));
+  } else {
+    gridSlot[id] = uvec2(kNoCell, 0u);
+  }
+}
@@ -0,0 +1,27 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/neighbour_grid.glsl"
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+
+layout(std430, binding = 11) readonly buffer GridSlotBuffer {
+  uvec2 gridSlot[];
+};
+
+const uint kNoCell = 0xffffffffu;
+
+void main() {
+  uint id;
+  if (!getAliveParticle(id)) return;
+
+  uvec2 slot = gridSlot[id];
+  if (slot.x == kNoCell) return;
+
+  gridEntry[gridCellRange[slot.x].x + slot.y] = GridEntry(particle[id].position, id);
+}
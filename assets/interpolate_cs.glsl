@@ -0,0 +1,29 @@
+#version 430 core
+
+#include "utils/particle.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) readonly buffer ParticleBuffer {
+  Particle particle[];
+};
+layout(std140, binding = 1) readonly buffer ParticlePrevBuffer {
+  Particle particlePrev[];
+};
+layout(std140, binding = 2) writeonly buffer ParticleInterpBuffer {
+  Particle particleInterp[];
+};
+
+uniform float alpha;
+
+// NOTE(ryan): Positions between the last two simulation ticks for drawing. Runs over every
+// particle, not just the alive list, since the sort that follows moves the whole pool. Dead ones
+// are zero scale so where they end up doesn't matter.
+void main() {
+  uint id = gl_GlobalInvocationID.x;
+  if (id >= PARTICLE_COUNT) return;
+
+  Particle p = particle[id];
+  p.position = mix(particlePrev[id].position, p.position, alpha);
+  particleInterp[id] = p;
+}
@@ -0,0 +1,23 @@
+#version 430 core
+
+#include "utils/noise.glsl"
+#include "utils/noise_field.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_XYZ, local_size_y = WORK_GROUP_SIZE_XYZ,
+       local_size_z = WORK_GROUP_SIZE_XYZ) in;
+
+layout(rgba16f, binding = 0) writeonly uniform image3D noiseFieldImg;
+
+uniform vec3 boundsMin, boundsMax;
+uniform uvec3 res;
+uniform uint sliceOffset, sliceEnd;
+uniform float bakeTime;
+
+void main() {
+  uvec3 c = gl_GlobalInvocationID + uvec3(0, 0, sliceOffset);
+  if (any(greaterThanEqual(c, uvec3(res.xy, sliceEnd)))) return;
+
+  // Sample at texel centers so trilinear filtering reconstructs the field in world space.
+  vec3 pos = mix(boundsMin, boundsMax, (vec3(c) + 0.5) / vec3(res));
+  imageStore(noiseFieldImg, ivec3(c), vec4(noiseFieldAnalytic(pos, bakeTime), 0.0));
+}
@@ -0,0 +1,10 @@
+#version 430 core
+
+// Counts fragments per pixel instead of shading them, see OverdrawHeatmap.
+layout(r32ui, binding = 0) uniform uimage2D overdrawImg;
+
+in vec4 color;
+
+void main() {
+  imageAtomicAdd(overdrawImg, ivec2(gl_FragCoord.xy), 1u);
+}
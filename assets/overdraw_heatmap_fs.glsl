@@ -0,0 +1,20 @@
+#version 430 core
+
+uniform usampler2D overdrawTex;
+uniform float heatmapMax;
+
+out vec4 fragColor;
+
+// Black, blue, green, yellow, red, white on a log scale up to heatmapMax fragments.
+vec3 heatmap(float t) {
+  const vec3 ramp[6] = vec3[](vec3(0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0),
+                              vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(1.0));
+  float x = clamp(t, 0.0, 1.0) * 5.0;
+  int i = min(int(x), 4);
+  return mix(ramp[i], ramp[i + 1], x - float(i));
+}
+
+void main() {
+  uint count = texelFetch(overdrawTex, ivec2(gl_FragCoord.xy), 0).r;
+  fragColor = vec4(heatmap(log2(1.0 + float(count)) / log2(1.0 + heatmapMax)), 1.0);
+}
@@ -0,0 +1,45 @@
+#version 430 core
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(r32ui, binding = 0) readonly uniform uimage2D overdrawImg;
+
+// Mirrors OverdrawHeatmap::Stats. Counts past the last bin land in it.
+layout(std430, binding = 0) buffer OverdrawStats {
+  uint totalLo, totalHi, statsPad0, statsPad1;
+  uint histogram[BIN_COUNT];
+};
+
+shared uint localHistogram[BIN_COUNT];
+shared uint localTotal;
+
+void main() {
+  uint local = gl_LocalInvocationIndex;
+  const uint groupSize = gl_WorkGroupSize.x * gl_WorkGroupSize.y;
+
+  for (uint i = local; i < BIN_COUNT; i += groupSize) localHistogram[i] = 0u;
+  if (local == 0u) localTotal = 0u;
+  memoryBarrierShared();
+  barrier();
+
+  // NOTE(ryan): Bin 0 would see nearly every pixel on screen, so the histogram is built in shared
+  // memory and only the touched bins are added to the global one.
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  if (all(lessThan(pixel, imageSize(overdrawImg)))) {
+    uint count = imageLoad(overdrawImg, pixel).r;
+    atomicAdd(localHistogram[min(count, BIN_COUNT - 1u)], 1u);
+    atomicAdd(localTotal, count);
+  }
+  memoryBarrierShared();
+  barrier();
+
+  for (uint i = local; i < BIN_COUNT; i += groupSize) {
+    if (localHistogram[i] != 0u) atomicAdd(histogram[i], localHistogram[i]);
+  }
+
+  // The total can pass 2^32 at high resolutions, carry into the high word.
+  if (local == 0u) {
+    uint prev = atomicAdd(totalLo, localTotal);
+    if (prev + localTotal < prev) atomicAdd(totalHi, 1u);
+  }
+}
@@ -0,0 +1,10 @@
+uniform sampler2D texture;
+
+in vec4 color;
+in vec2 texCoord;
+
+out vec4 fragColor;
+
+void main() {
+  fragColor = color * texture2D(texture, texCoord).r;
+}
@@ -0,0 +1,37 @@
+#version 430 core
+
+#include "utils/camera_constants.glsl"
+#include "utils/particle.glsl"
+#include "utils/splat_size.glsl"
+
+uniform float pointSize;
+uniform vec2 viewportSize;
+uniform bool lodEnabled;
+uniform float lodDistance;
+
+layout(std140, binding = 0) buffer Particles {
+  Particle particle[];
+};
+
+out vec4 color;
+out vec2 texCoord;
+
+// NOTE(ryan): Vertex pulling. One instance per sorted particle, each a 4 vertex triangle strip
+// expanded to a screen aligned quad the same size render_vs.glsl would make the point, but without
+// the implementation's point size limit.
+void main() {
+  Particle p = particle[gl_InstanceID];
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+  color = p.color;
+  texCoord = corner;
+  gl_Position = cameraViewProjection * vec4(p.position, 1.0);
+
+  float size = clampSplatSize((pointSize * p.scale) / gl_Position.w, color);
+  gl_Position.xy += (corner * 2.0 - 1.0) * (size / viewportSize) * gl_Position.w;
+
+  // See render_vs.glsl.
+  if (lodEnabled && gl_Position.w >= lodDistance) {
+    gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+  }
+}
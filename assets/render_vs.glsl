@@ -1,19 +1,30 @@
 #version 430 core
 
+#include "utils/camera_constants.glsl"
 #include "utils/particle.glsl"
+#include "utils/splat_size.glsl"
 
-uniform mat4 ciModelViewProjection;
 uniform float pointSize;
+uniform bool lodEnabled;
+uniform float lodDistance;
 
-layout(location = 0) in uint particleId;
 layout(std140, binding = 0) buffer Particles {
   Particle particle[];
 };
 
 out vec4 color;
 
+// NOTE(ryan): Drawn without attributes, the vertex index is the sorted particle index.
 void main() {
-  color = particle[particleId].color;
-  gl_Position = ciModelViewProjection * vec4(particle[particleId].position, 1.0);
-  gl_PointSize = (pointSize * particle[particleId].scale) / gl_Position.w;
+  Particle p = particle[gl_VertexID];
+
+  color = p.color;
+  gl_Position = cameraViewProjection * vec4(p.position, 1.0);
+  gl_PointSize = clampSplatSize((pointSize * p.scale) / gl_Position.w, color);
+
+  // Far particles are covered by the volume raymarch. Clip w is the view depth, the raymarch
+  // starts at a distance along the ray, close enough at the sizes we draw.
+  if (lodEnabled && gl_Position.w >= lodDistance) {
+    gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+  }
 }
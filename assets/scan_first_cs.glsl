@@ -119,16 +119,17 @@ layout(binding = 3, std430) writeonly buffer FlagsData
 
 shared uvec4 sharedData[gl_WorkGroupSize.x];
 
+#include "utils/frame_constants.glsl"
+
 uniform int bitOffset;
-uniform vec3 axis;
-uniform float zMin;
-uniform float zMax;
 
 /*
  * The particles are sorted by increasing distance along the sorting axis.
  * We find the distance by a simple dot product. The sorting algorithm
  * needs integer keys (16-bit in this case), so we convert the distance from
- * the range [zMin, zMax] -> [0, 65535].
+ * the range [sortZMin, sortZMax] -> [0, 65535].
+ * Dead particles (zero scale) get the one key no live particle can have, so they all end up
+ * at the back and drawing the first aliveCount sorted particles draws exactly the live ones.
  * Finally we extract the current working digits (2-bit in this case) from the key.
  *
  * Read four particles at once to improve vectorization a bit.
@@ -136,11 +137,17 @@ uniform float zMax;
 uvec4 decodeKeys(uint index)
 {
     vec4 z = vec4(
-            dot(in_points[4u * index + 0u].pos.xyz, axis),
-            dot(in_points[4u * index + 1u].pos.xyz, axis),
-            dot(in_points[4u * index + 2u].pos.xyz, axis),
-            dot(in_points[4u * index + 3u].pos.xyz, axis));
-    z = 65535.0 * clamp((z - zMin) / (zMax - zMin), vec4(0.0), vec4(1.0));
+            dot(in_points[4u * index + 0u].pos.xyz, sortAxis),
+            dot(in_points[4u * index + 1u].pos.xyz, sortAxis),
+            dot(in_points[4u * index + 2u].pos.xyz, sortAxis),
+            dot(in_points[4u * index + 3u].pos.xyz, sortAxis));
+    vec4 scale = vec4(
+            in_points[4u * index + 0u].pos.w,
+            in_points[4u * index + 1u].pos.w,
+            in_points[4u * index + 2u].pos.w,
+            in_points[4u * index + 3u].pos.w);
+    z = 65534.0 * clamp((z - sortZMin) / (sortZMax - sortZMin), vec4(0.0), vec4(1.0));
+    z = mix(z, vec4(65535.0), equal(scale, vec4(0.0)));
     return bitfieldExtract(uvec4(z), bitOffset, 2);
 }
 
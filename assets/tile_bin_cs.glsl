@@ -0,0 +1,34 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/particle.glsl"
+#include "utils/splat_tiles.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) readonly buffer ParticleBuffer {
+  Particle particle[];
+};
+
+// NOTE(ryan): tileCount was cleared again after the ranges were built and is used here to hand out
+// slots. Slots come from atomics, so each tile's entries are only roughly in rank order, following
+// the order the work groups happen to run in. tile_raster_cs sorts each whole list.
+void main() {
+  uint rank = gl_GlobalInvocationID.x;
+  if (rank >= aliveCount) return;
+
+  vec2 centre;
+  float radius;
+  uvec2 tileMin, tileMax;
+  if (!projectSplat(particle[aliveCount - 1u - rank], centre, radius)) return;
+  if (!getSplatTiles(centre, radius, tileMin, tileMax)) return;
+
+  for (uint y = tileMin.y; y <= tileMax.y; ++y) {
+    for (uint x = tileMin.x; x <= tileMax.x; ++x) {
+      uint tile = y * tileRes.x + x;
+      uint slot = atomicAdd(tileCount[tile].x, 1u);
+      uvec2 range = tileRange[tile];
+      if (slot < range.y) tileEntry[range.x + slot] = rank;
+    }
+  }
+}
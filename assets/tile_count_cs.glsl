@@ -0,0 +1,28 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/particle.glsl"
+#include "utils/splat_tiles.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) readonly buffer ParticleBuffer {
+  Particle particle[];
+};
+
+void main() {
+  uint rank = gl_GlobalInvocationID.x;
+  if (rank >= aliveCount) return;
+
+  vec2 centre;
+  float radius;
+  uvec2 tileMin, tileMax;
+  if (!projectSplat(particle[aliveCount - 1u - rank], centre, radius)) return;
+  if (!getSplatTiles(centre, radius, tileMin, tileMax)) return;
+
+  for (uint y = tileMin.y; y <= tileMax.y; ++y) {
+    for (uint x = tileMin.x; x <= tileMax.x; ++x) {
+      atomicAdd(tileCount[y * tileRes.x + x].x, 1u);
+    }
+  }
+}
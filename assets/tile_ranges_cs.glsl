@@ -0,0 +1,29 @@
+#version 430 core
+
+#include "utils/particle.glsl"
+#include "utils/splat_tiles.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+// RadixSort's scan output, see RadixSort::scan.
+layout(std430, binding = 1) readonly buffer ScanBuffer {
+  uvec4 scanBuf[];
+};
+layout(std430, binding = 2) readonly buffer BlockSumBuffer {
+  uvec4 blockSum[];
+};
+
+uniform uint scanBlockSize, entryCapacity;
+
+void main() {
+  uint tile = gl_GlobalInvocationID.x;
+  if (tile >= tileRes.x * tileRes.y) return;
+
+  uint block = tile / scanBlockSize;
+  uint end = scanBuf[tile].x + (block > 0u ? blockSum[block - 1u].x : 0u);
+  uint begin = end - tileCount[tile].x;
+
+  // Whatever doesn't fit in the entry buffer is dropped, from the last tiles first.
+  uint count = begin < entryCapacity ? min(end, entryCapacity) - begin : 0u;
+  tileRange[tile] = uvec2(begin, count);
+}
@@ -0,0 +1,96 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/particle.glsl"
+#include "utils/splat_tiles.glsl"
+
+// One work group per tile, one invocation per pixel.
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(std140, binding = 0) readonly buffer ParticleBuffer {
+  Particle particle[];
+};
+
+layout(rgba16f, binding = 0) writeonly uniform image2D outputImg;
+
+uniform sampler2D splatTex;
+
+const uint kBatchSize = 256u;
+const float kOpaqueAlpha = 0.995;
+
+shared vec4 batchSplat[kBatchSize]; // Centre, 1 / radius, mip level.
+shared vec4 batchColor[kBatchSize];
+shared uint opaqueCount;
+
+void main() {
+  uint local = gl_LocalInvocationIndex;
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  vec2 pixelCentre = vec2(pixel) + 0.5;
+  bool onScreen = all(lessThan(pixelCentre, viewportSize));
+
+  uvec2 range = tileRange[gl_WorkGroupID.y * tileRes.x + gl_WorkGroupID.x];
+
+  // NOTE(ryan): Sort the tile's whole list by rank in place before blending. The batches have to
+  // come front to back as well, or the opacity early out stops before splats that belong in front.
+  // Every compare puts the smaller rank first, so the list can be treated as padded to a power of
+  // two with ranks past its end that never move, and the compares against those are skipped.
+  uint sortSize = 1u;
+  while (sortSize < range.y) sortSize <<= 1u;
+  for (uint k = 2u; k <= sortSize; k <<= 1u) {
+    for (uint j = k >> 1u; j > 0u; j >>= 1u) {
+      for (uint i = local; i < sortSize; i += kBatchSize) {
+        // The first pass of each merge compares mirrored pairs, the rest compare j apart.
+        uint other = j == k >> 1u ? i ^ (k - 1u) : i ^ j;
+        if (other > i && other < range.y) {
+          uint a = tileEntry[range.x + i], b = tileEntry[range.x + other];
+          if (a > b) {
+            tileEntry[range.x + i] = b;
+            tileEntry[range.x + other] = a;
+          }
+        }
+      }
+      memoryBarrierBuffer();
+      barrier();
+    }
+  }
+  float texLevels = log2(float(textureSize(splatTex, 0).x));
+
+  // Premultiplied, accumulated front to back. Off screen pixels count as opaque from the start.
+  vec4 result = vec4(0.0);
+  bool opaque = !onScreen;
+
+  for (uint base = 0u; base < range.y; base += kBatchSize) {
+    uint batchCount = min(range.y - base, kBatchSize);
+
+    // Each invocation fetches one splat of the batch.
+    if (local == 0u) opaqueCount = 0u;
+    if (local < batchCount) {
+      Particle p = particle[aliveCount - 1u - tileEntry[range.x + base + local]];
+      vec2 centre;
+      float radius;
+      projectSplat(p, centre, radius);
+      batchSplat[local] = vec4(centre, 1.0 / radius, max(texLevels - log2(2.0 * radius), 0.0));
+      batchColor[local] = p.color;
+    }
+    memoryBarrierShared();
+    barrier();
+
+    for (uint i = 0u; i < batchCount && !opaque; ++i) {
+      vec4 splat = batchSplat[i];
+      vec2 uv = (pixelCentre - splat.xy) * splat.z * 0.5 + 0.5;
+      if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) continue;
+
+      vec4 src = batchColor[i] * textureLod(splatTex, uv, splat.w).r;
+      result += (1.0 - result.a) * src;
+      opaque = result.a >= kOpaqueAlpha;
+    }
+
+    // Stop the whole tile once every pixel in it is opaque.
+    if (opaque) atomicAdd(opaqueCount, 1u);
+    memoryBarrierShared();
+    barrier();
+    if (opaqueCount == kBatchSize) break;
+  }
+
+  if (onScreen) imageStore(outputImg, pixel, result);
+}
@@ -0,0 +1,38 @@
+#version 430 core
+
+#include "utils/alive_list.glsl"
+#include "utils/particle.glsl"
+#include "utils/trajectory_frame.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) buffer ParticleBuffer {
+  Particle particle[];
+};
+layout(std140, binding = 1) writeonly buffer ParticlePrevBuffer {
+  Particle particlePrev[];
+};
+
+uint getLane(uint lane, uint id) {
+  uint word = trajectoryFrame[getTrajectoryWordIndex(lane, id / 2u)];
+  return (id & 1u) != 0u ? word >> 16 : word & 0xffffu;
+}
+
+// NOTE(ryan): Stands in for the update shader during playback. The alive list is rebuilt from
+// scratch each frame out of whatever has non-zero scale, the dead list is left alone.
+void main() {
+  uint id = gl_GlobalInvocationID.x;
+  if (id >= PARTICLE_COUNT) return;
+
+  Particle p;
+  uvec3 q = uvec3(getLane(0u, id), getLane(1u, id), getLane(2u, id));
+  p.position = trajectoryBoundsMin + vec3(q) / 65535.0 * trajectoryBoundsSize;
+  p.scale = unpackHalf2x16(getLane(3u, id)).x;
+  p.color.rg = unpackHalf2x16(getLane(4u, id) | (getLane(5u, id) << 16));
+  p.color.ba = unpackHalf2x16(getLane(6u, id) | (getLane(7u, id) << 16));
+
+  particlePrev[id] = particle[id];
+  particle[id] = p;
+
+  if (p.scale > 0.0) keepParticle(id);
+}
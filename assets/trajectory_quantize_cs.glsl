@@ -0,0 +1,40 @@
+#version 430 core
+
+#include "utils/particle.glsl"
+#include "utils/trajectory_frame.glsl"
+
+layout(local_size_x = WORK_GROUP_SIZE_X) in;
+
+layout(std140, binding = 0) readonly buffer ParticleBuffer {
+  Particle particle[];
+};
+
+void quantizeParticle(Particle p, out uint lanes[kTrajectoryLaneCount]) {
+  vec3 unit = clamp((p.position - trajectoryBoundsMin) / trajectoryBoundsSize, 0.0, 1.0);
+  uvec3 q = uvec3(round(unit * 65535.0));
+  uint scale = packHalf2x16(vec2(p.scale, 0.0));
+  uint rg = packHalf2x16(p.color.rg), ba = packHalf2x16(p.color.ba);
+
+  lanes[0] = q.x;
+  lanes[1] = q.y;
+  lanes[2] = q.z;
+  lanes[3] = scale;
+  lanes[4] = rg & 0xffffu;
+  lanes[5] = rg >> 16;
+  lanes[6] = ba & 0xffffu;
+  lanes[7] = ba >> 16;
+}
+
+// NOTE(ryan): One invocation per pair of particles, so each word of the frame has one writer.
+void main() {
+  uint pair = gl_GlobalInvocationID.x;
+  if (pair >= PARTICLE_COUNT / 2u) return;
+
+  uint lo[kTrajectoryLaneCount], hi[kTrajectoryLaneCount];
+  quantizeParticle(particle[pair * 2u], lo);
+  quantizeParticle(particle[pair * 2u + 1u], hi);
+
+  for (uint lane = 0u; lane < kTrajectoryLaneCount; ++lane) {
+    trajectoryFrame[getTrajectoryWordIndex(lane, pair)] = lo[lane] | (hi[lane] << 16);
+  }
+}
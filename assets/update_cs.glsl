@@ -1,6 +1,13 @@
 #version 430 core
 
+#include "utils/alive_list.glsl"
+#include "utils/density_cascades.glsl"
+#include "utils/emitter.glsl"
+#include "utils/force_fields.glsl"
+#include "utils/frame_constants.glsl"
 #include "utils/noise.glsl"
+#include "utils/neighbour_grid.glsl"
+#include "utils/noise_field.glsl"
 #include "utils/particle.glsl"
 
 
@@ -13,19 +20,18 @@ layout(std140, binding = 1) buffer ParticlePrevBuffer {
   Particle particlePrev[];
 };
 
-uniform float time;
-uniform uint frameId;
-uniform vec3 eyePos, eyeVel, viewDir;
-
-uniform bool init, compile;
-
-uniform vec3 volumeBoundsMin, volumeBoundsMax;
-uniform uvec3 volumeRes;
-uniform mat4 worldToUnitVolumeMtx;
-
 uniform usampler3D densityTex;
 uniform sampler3D densityGradTex;
 
+uniform bool fluidEnabled;
+uniform sampler3D fluidVelocityTex, fluidVelocityPrevTex;
+uniform float fluidFlipRatio;
+
+// Length of this tick relative to the reference tick the forces were tuned at (1 / 60 s), see
+// ParticleSys::update. Velocities are kept in distance per reference tick and every per-tick
+// change is scaled by it, so the simulation runs at the same speed whatever the tick rate.
+uniform float tickScale;
+
 
 vec3 worldToVolumeTexcoord(in vec3 pos) {
   return vec3(worldToUnitVolumeMtx * vec4(pos, 1.0));
@@ -75,87 +81,109 @@ float ramp(float e1, float e2, float x) {
 
 
 void main() {
-  uint id = gl_GlobalInvocationID.x;
+  uint id;
+  if (!getAliveParticle(id)) return;
 
   float t = float(id) / float(PARTICLE_COUNT);
 
   vec3 pos = particle[id].position;
-  vec3 vel = pos - particlePrev[id].position;
-  vel *= 0.7;
+  vec3 vel = (pos - particlePrev[id].position) / tickScale;
   particlePrev[id] = particle[id];
 
   vec3 texcoord = worldToVolumeTexcoord(pos);
-  vec3 dg = texture(densityGradTex, texcoord).xyz;
-  float d = float(texture(densityTex, texcoord).r);
-
-  float h11t = hash11(t);
-
-  const float cycleDuration = 2000.0;
-  int age = int(mod(t * cycleDuration - float(frameId), cycleDuration));
-  // age = int(frameId) % 100;
-
-  bool flotsam = t < 0.025;
-  bool spawn =
-      init || age == 0 ||
-      (!flotsam && (any(greaterThan(texcoord, vec3(1.0))) || any(lessThan(texcoord, vec3(0.0)))));
-
-  if (spawn) {
-    vec3 p;
-    if (flotsam) {
-      p = randVec3(t) * sqrt(h11t) * 4.0;
-    } else {
-      p = randVec3(t) * mix(0.5, 0.8, h11t);
+  vec3 dg;
+  float d;
+  if (!sampleDensityCascades(pos, d, dg)) {
+    dg = texture(densityGradTex, texcoord).xyz;
+    d = float(texture(densityTex, texcoord).r);
+  }
+
+  if (fluidEnabled) {
+    // Blend of the projected grid velocity (PIC) and our own plus the grid's change (FLIP). The
+    // grid holds per tick displacements like particlePrev does.
+    vec4 gridVel = texture(fluidVelocityTex, texcoord);
+    if (gridVel.w > 0.0) {
+      gridVel.xyz /= tickScale;
+      vec3 gridVelPrev = texture(fluidVelocityPrevTex, texcoord).xyz / tickScale;
+      vel = mix(gridVel.xyz, vel + gridVel.xyz - gridVelPrev, fluidFlipRatio);
     }
-    particle[id].position = p;
-    particlePrev[id].position = p; // - vec3(0.1, 0.0, 0.0);
   } else {
-    vec3 scale = vec3(2.0, 2.01, 2.05);
-    vec3 q = scale * pos + kHashScale3 + vec3(time) * vec3(0.05, 0.07, 0.09);
-    vec3 dN = SimplexPerlin3D_Deriv(q).xyz + 0.7 * SimplexPerlin3D_Deriv(q * 5.01).xyz;
-    dN += -normalize(pos) * t * 0.0005;
-    // vec3 v1 = dN;
-    vec3 v1 = dN + vec3(dN.y - dN.z, dN.z - dN.x, dN.x - dN.y);
-
-    vel += v1 * 0.00001;
+    vel *= pow(0.7, tickScale);
+  }
 
-    vec3 eyeDir = pos - eyePos;
-    float eyePow = smoothstep(0.4, 0.0, length(eyeDir));
-    eyeDir = normalize(eyeDir);
-    vel += max(0.0, dot(eyeDir, eyeVel)) * eyeDir * eyePow;
+  uint flags = particleLife[id].flags;
+  particleLife[id].age += timeDelta;
 
-    // vel -= dg * 0.00001;
-    // vel += normalize(pos).yxx * vec3(1.0, -1.0, 0.0) * 0.001;
+  bool expired = particleLife[id].age >= particleLife[id].lifetime;
+  bool outOfBounds = any(greaterThan(texcoord, vec3(1.0))) || any(lessThan(texcoord, vec3(0.0)));
 
-    // vel += -normalize(pos) * t * 0.0005;
+  if (expired || (outOfBounds && (flags & kEmitterUnbounded) == 0u)) {
+    particle[id].scale = 0.0;
+    particle[id].color = vec4(0.0);
+    killParticle(id);
+    return;
+  }
 
-    particle[id].position = pos + vel; // mix(0.5, 0.8, t);
+  vec3 dN = noiseField(pos, time);
+  dN += -normalize(pos) * t * 0.0005;
+  // vec3 v1 = dN;
+  vec3 v1 = dN + vec3(dN.y - dN.z, dN.z - dN.x, dN.x - dN.y);
+
+  vel += v1 * (0.00001 * tickScale);
+
+  vec3 eyeDir = pos - eyePos;
+  float eyePow = smoothstep(0.4, 0.0, length(eyeDir));
+  eyeDir = normalize(eyeDir);
+  // eyeVel is the eye's movement over this tick, which already scales with its length.
+  vel += max(0.0, dot(eyeDir, eyeVel)) * eyeDir * eyePow;
+
+  applyForceFields(pos, texcoord, tickScale, vel);
+
+  if (gridEnabled) {
+    // Push apart from the first few particles within a cell's width.
+    const uint kMaxNeighbours = 32u;
+    float radius = 1.0 / gridOneOverCellSize;
+    vec3 sep = vec3(0.0);
+    uint visited = 0u;
+    ivec3 c = gridCellCoord(pos);
+    for (int i = 0; i < 27 && visited < kMaxNeighbours; ++i) {
+      uint cell;
+      if (!gridCellIndex(c + gridNeighbourOffset(i), cell)) continue;
+      uvec2 range = gridCellRange[cell];
+      for (uint j = range.x; j < range.x + range.y && visited < kMaxNeighbours; ++j) {
+        GridEntry n = gridEntry[j];
+        vec3 dp = pos - n.position;
+        float dist = length(dp);
+        if (n.id == id || dist >= radius || dist == 0.0) continue;
+        sep += dp / dist * (1.0 - dist / radius);
+        ++visited;
+      }
+    }
+    vel += sep * (0.00002 * tickScale);
   }
 
+  // vel -= dg * 0.00001;
+  // vel += normalize(pos).yxx * vec3(1.0, -1.0, 0.0) * 0.001;
+
+  // vel += -normalize(pos) * t * 0.0005;
+
+  particle[id].position = pos + vel * tickScale; // mix(0.5, 0.8, t);
+
   // float wave = (sin(time + particle[id].position.z * kTwoPi * 0.5) + 1.0) * 0.5;
   // particle[id].color.rgb = pal(t, vec3(0.5, 0.5, 0.5), vec3(0.5, 0.5, 0.5), vec3(1.0, 1.0,
   // 0.5), vec3(0.8, 0.90, 0.30));
-  vec4 c = vec4(1.0);
   // float viewDist = distance(eyePos, particle[id].position);
   // float d = ramp(5.0, 2.0, viewDist);
   // c.rgb = pal(d, vec3(1.118,0.680,0.750), vec3(1.008,0.600,0.600), vec3(0.318,0.330,0.310),
   // vec3(-0.440,-0.447,-0.500));
 
-  c.rgb = dg * 0.005;
+  // Scale and color stay as emitted. Tinted emitters scale their color by the density gradient.
+  uint e = particleLife[id].emitter;
+  if ((flags & kEmitterDensityTint) != 0u && e < uint(emitter.length())) {
+    particle[id].color = vec4(emitter[e].color.rgb * dg * 0.005, emitter[e].color.a);
+  }
   // float a = time * 0.1;
   // c.rgb = vec3(clamp(dot(normalize(dg), vec3(sin(a), cos(a), 0.0)), 0.0, 1.0));
-  c.a = 1.0;
-
-  c *= 0.25f;
-  c.g *= 0.25;
-
-  float s;
-  if (flotsam) {
-    c = vec4(0.1);
-    s = mix(1.0, 2.0, h11t);
-  } else {
-    s = mix(1.0, 4.0, h11t);
-  }
 
-  particle[id].color = spawn ? vec4(0.0) : c;
-  particle[id].scale = s; // fract(time / 5.0) > 0.5 ? 2.0 : 0.0;
+  keepParticle(id);
 }
@@ -0,0 +1,44 @@
+#version 430 core
+
+uniform sampler2D particleTex;      // Low resolution, premultiplied.
+uniform sampler2D particleDepthTex; // Low resolution scene depth the particles were tested against.
+uniform sampler2D sceneDepthTex;
+uniform int downsample;
+
+// Projection matrix [3][2] and [2][2], enough to turn window depth back into view distance.
+uniform vec2 depthParams;
+uniform float depthTolerance;
+
+out vec4 fragColor;
+
+float linearDepth(float depth) {
+  return depthParams.x / (depth * 2.0 - 1.0 + depthParams.y);
+}
+
+// NOTE(ryan): Joint bilateral upsample. The four low resolution texels around the pixel are
+// weighted bilinearly as usual, then by how close their depth is to the full resolution scene
+// depth, so particles don't bleed across the edges of whatever is in front of or behind them.
+void main() {
+  float depth = linearDepth(texelFetch(sceneDepthTex, ivec2(gl_FragCoord.xy), 0).r);
+
+  vec2 lowPos = gl_FragCoord.xy / float(downsample) - 0.5;
+  ivec2 lowBase = ivec2(floor(lowPos));
+  ivec2 lowMax = textureSize(particleTex, 0) - 1;
+  vec2 f = lowPos - vec2(lowBase);
+
+  vec4 sum = vec4(0.0);
+  float weightSum = 0.0;
+  for (int i = 0; i < 4; ++i) {
+    ivec2 offset = ivec2(i & 1, i >> 1);
+    ivec2 coord = clamp(lowBase + offset, ivec2(0), lowMax);
+
+    vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+    float lowDepth = linearDepth(texelFetch(particleDepthTex, coord, 0).r);
+    float weight = bilinear.x * bilinear.y / (depthTolerance + abs(lowDepth - depth) / depth);
+
+    sum += weight * texelFetch(particleTex, coord, 0);
+    weightSum += weight;
+  }
+
+  fragColor = sum / max(weightSum, 1e-6);
+}
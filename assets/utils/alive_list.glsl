@@ -0,0 +1,44 @@
+// Alive/dead bookkeeping shared by the emit, update and density passes. Mirrors the buffers owned
+// by ParticleEmitters in include/Emitters.hpp. Dead particles are also zero scale, which the sort
+// uses to push them behind every live particle.
+
+struct ParticleLife {
+  float age, lifetime;
+  uint emitter, flags; // The emitter's flags when it spawned, see utils/emitter.glsl.
+};
+
+layout(std430, binding = 2) buffer ParticleCounters {
+  int deadCount;
+  uint aliveCount, aliveNextCount, countersPad0;
+  uint aliveDispatch[3], countersPad1;
+  uint aliveDraw[4];
+  uint aliveQuadDraw[4];
+};
+
+layout(std430, binding = 3) buffer AliveList {
+  uint aliveList[];
+};
+layout(std430, binding = 4) buffer AliveNextList {
+  uint aliveNextList[];
+};
+layout(std430, binding = 5) buffer DeadList {
+  uint deadList[];
+};
+layout(std430, binding = 6) buffer ParticleLifeBuffer {
+  ParticleLife particleLife[];
+};
+
+// Maps the invocation to a live particle. False for the padding invocations of the last group.
+bool getAliveParticle(out uint id) {
+  if (gl_GlobalInvocationID.x >= aliveCount) return false;
+  id = aliveList[gl_GlobalInvocationID.x];
+  return true;
+}
+
+// Every live particle must be passed to exactly one of these per update.
+void keepParticle(uint id) {
+  aliveNextList[atomicAdd(aliveNextCount, 1u)] = id;
+}
+void killParticle(uint id) {
+  deadList[atomicAdd(deadCount, 1)] = id;
+}
@@ -0,0 +1,9 @@
+// The draw camera, latched just before drawing. Mirrors CameraConstants::Data in
+// include/CameraConstants.hpp.
+
+layout(std140, binding = 1) uniform CameraConstants {
+  mat4 cameraViewProjection;
+  mat4 cameraView;
+  mat4 cameraProjection;
+  vec3 cameraEyePos;
+};
@@ -0,0 +1,72 @@
+// Camera-centred density cascades, clipmap style, built by DensityCascades
+// (include/DensityCascades.hpp). Cascade i has cells 2^i times the size of cascade 0's, all at
+// cascadeRes^3, each snapped to whole cells around the eye. Texels are addressed toroidally (world
+// cell modulo cascadeRes), so a cell keeps its texel while the cascade scrolls with the camera.
+
+#define MAX_DENSITY_CASCADES 4
+
+uniform int cascadeCount; // Zero when the cascades are off.
+uniform int cascadeRes;
+uniform ivec3 cascadeOriginCell[MAX_DENSITY_CASCADES];
+uniform float cascadeOneOverCellSize[MAX_DENSITY_CASCADES];
+uniform usampler3D cascadeDensityTex[MAX_DENSITY_CASCADES];
+uniform sampler3D cascadeGradTex[MAX_DENSITY_CASCADES];
+
+// cascadeRes is a power of two, so the mask wraps negative cells too. % is undefined for them.
+ivec3 cascadeTexel(ivec3 cell) {
+  return cell & ivec3(cascadeRes - 1);
+}
+
+// Finest cascade holding pos, -1 if none. The two outermost cells on each side are left out. The
+// gradient's filtered lookup reaches half a cell out and the gradient itself was taken from the
+// cells either side, so anything closer than 1.5 cells to the edge blends in the far side.
+int findDensityCascade(vec3 pos) {
+  const float margin = 2.0;
+  for (int i = 0; i < cascadeCount; ++i) {
+    vec3 cell = pos * cascadeOneOverCellSize[i] - vec3(cascadeOriginCell[i]);
+    if (all(greaterThanEqual(cell, vec3(margin))) &&
+        all(lessThan(cell, vec3(float(cascadeRes) - margin)))) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Density and gradient from the finest cascade holding pos, rescaled to cascade 0's cell size so
+// every cascade reads like the fixed volume does. False outside all of them.
+bool sampleDensityCascades(vec3 pos, out float density, out vec3 grad) {
+  int i = findDensityCascade(pos);
+  if (i < 0) return false;
+
+  vec3 cell = pos * cascadeOneOverCellSize[i];
+  ivec3 texel = cascadeTexel(ivec3(floor(cell)));
+  // The gradient volumes wrap with GL_REPEAT, which is the toroidal addressing for free.
+  vec3 texcoord = cell / float(cascadeRes);
+
+  // Sampler arrays can only be indexed by constants (or dynamically uniform values).
+  uint count;
+  vec3 g;
+  switch (i) {
+    case 0:
+      count = texelFetch(cascadeDensityTex[0], texel, 0).r;
+      g = texture(cascadeGradTex[0], texcoord).xyz;
+      break;
+    case 1:
+      count = texelFetch(cascadeDensityTex[1], texel, 0).r;
+      g = texture(cascadeGradTex[1], texcoord).xyz;
+      break;
+    case 2:
+      count = texelFetch(cascadeDensityTex[2], texel, 0).r;
+      g = texture(cascadeGradTex[2], texcoord).xyz;
+      break;
+    default:
+      count = texelFetch(cascadeDensityTex[3], texel, 0).r;
+      g = texture(cascadeGradTex[3], texcoord).xyz;
+      break;
+  }
+
+  // Each step up has 8x the volume per cell and 2x the distance between cells.
+  density = float(count) * exp2(-3.0 * float(i));
+  grad = g * exp2(-4.0 * float(i));
+  return true;
+}
@@ -0,0 +1,23 @@
+// Emitter descriptors from ParticleEmitters (include/Emitters.hpp), uploaded every emit and bound
+// with ParticleEmitters::bindEmitters.
+
+// Mirrors Emitter in include/Emitters.hpp (std430).
+struct Emitter {
+  vec3 position;
+  float radiusMin;
+  vec3 velocity;
+  float radiusMax;
+  vec4 color;
+  float scaleMin, scaleMax, lifetime, rate;
+  uint spawnOffset, spawnCount;
+  float spawnAccum;
+  uint flags;
+};
+
+// Mirror the Emitter::k* flags, copied into ParticleLife.flags at spawn.
+const uint kEmitterDensityTint = 1u << 0;
+const uint kEmitterUnbounded = 1u << 1;
+
+layout(std430, binding = 7) readonly buffer EmitterBuffer {
+  Emitter emitter[];
+};
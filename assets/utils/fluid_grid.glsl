@@ -0,0 +1,13 @@
+// Shared by the fluid_*_cs grid passes, see FluidSolver. Velocities are in world units per tick,
+// the w component of the velocity volume is the splatted particle weight and marks fluid cells.
+// Walls are solid (zero velocity, zero pressure gradient), empty cells are air (zero pressure).
+
+layout(local_size_x = WORK_GROUP_SIZE_XYZ, local_size_y = WORK_GROUP_SIZE_XYZ,
+       local_size_z = WORK_GROUP_SIZE_XYZ) in;
+
+const ivec3 kNeighbourOffsets[6] = ivec3[6](ivec3(1, 0, 0), ivec3(-1, 0, 0), ivec3(0, 1, 0),
+                                            ivec3(0, -1, 0), ivec3(0, 0, 1), ivec3(0, 0, -1));
+
+bool isInside(ivec3 c) {
+  return all(greaterThanEqual(c, ivec3(0))) && all(lessThan(c, ivec3(volumeRes)));
+}
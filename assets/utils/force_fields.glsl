@@ -0,0 +1,112 @@
+// Force fields from ForceFields (include/ForceFields.hpp). Each tick force_bin_cs.glsl bins the
+// descriptors into a coarse grid over the volume, every cell holding a 64 bit mask of the fields
+// whose bounds reach it, so a particle only evaluates the few fields around it. Cells on the
+// edge of the grid extend out to infinity, particles outside the volume use the nearest one.
+// Check forceFieldCount first, the buffers aren't bound when there are no fields.
+
+// Mirrors ForceField in include/ForceFields.hpp (std430).
+struct ForceField {
+  vec3 position;
+  uint type;
+  vec3 axis;
+  float strength;
+  float radius;
+  uint volume;
+  uint pad0, pad1;
+  vec3 boundsMin;
+  uint pad2;
+  vec3 boundsMax;
+  uint pad3;
+};
+
+const uint kForceFieldAttractor = 0u;
+const uint kForceFieldVortex = 1u;
+const uint kForceFieldPlane = 2u;
+const uint kForceFieldSdf = 3u;
+
+// Mirror ForceFields::kBinRes, kSdfRes and kMaxSdfVolumes.
+const int kForceFieldBinRes = 16;
+const float kForceSdfRes = 32.0;
+const float kForceSdfMaxVolumes = 8.0;
+
+layout(std430, binding = 19) readonly buffer ForceFieldBuffer {
+  ForceField forceField[];
+};
+layout(std430, binding = 20) buffer ForceFieldBinBuffer {
+  uvec2 forceFieldBin[];
+};
+
+uniform uint forceFieldCount;
+// Baked SDF volumes stacked along z, kForceSdfRes slices each.
+uniform sampler3D forceSdfTex;
+
+
+uint forceFieldBinIndex(in ivec3 cell) {
+  return uint((cell.z * kForceFieldBinRes + cell.y) * kForceFieldBinRes + cell.x);
+}
+
+// Clamped in z to the volume's own slices so neighbouring volumes don't bleed in.
+float forceSdfDistance(in uint volume, in vec3 local) {
+  vec3 texel = local * kForceSdfRes;
+  texel.z = clamp(texel.z, 0.5, kForceSdfRes - 0.5) + float(volume) * kForceSdfRes;
+  return texture(forceSdfTex, texel / vec3(kForceSdfRes, kForceSdfRes,
+                                           kForceSdfRes * kForceSdfMaxVolumes)).r;
+}
+
+// Pushes out along the normal inside the margin and cancels any velocity further in.
+void collide(in vec3 normal, in float dist, in ForceField f, in float tickScale, inout vec3 vel) {
+  if (dist >= f.radius) return;
+  vel += normal * ((f.radius - dist) * f.strength * tickScale - min(dot(vel, normal), 0.0));
+}
+
+// tickScale is the tick's length in reference ticks, strengths are per reference tick.
+void applyForceField(in ForceField f, in vec3 pos, in float tickScale, inout vec3 vel) {
+  if (f.type == kForceFieldAttractor) {
+    vec3 dp = f.position - pos;
+    float dist = length(dp);
+    if (dist >= f.radius || dist == 0.0) return;
+    float w = 1.0 - dist / f.radius;
+    vel += dp / dist * f.strength * tickScale * w * w;
+  } else if (f.type == kForceFieldVortex) {
+    // Swirls around the closest point on the segment from position to position + axis.
+    float along = clamp(dot(pos - f.position, f.axis) / dot(f.axis, f.axis), 0.0, 1.0);
+    vec3 radial = pos - (f.position + f.axis * along);
+    float dist = length(radial);
+    if (dist >= f.radius || dist == 0.0) return;
+    float w = 1.0 - dist / f.radius;
+    vel += cross(normalize(f.axis), radial / dist) * f.strength * tickScale * w * w;
+  } else if (f.type == kForceFieldPlane) {
+    collide(f.axis, dot(pos - f.position, f.axis), f, tickScale, vel);
+  } else if (f.type == kForceFieldSdf) {
+    vec3 size = f.boundsMax - f.boundsMin;
+    vec3 local = (pos - f.boundsMin) / size;
+    if (any(lessThan(local, vec3(0.0))) || any(greaterThan(local, vec3(1.0)))) return;
+
+    const float h = 1.0 / kForceSdfRes;
+    vec3 grad = vec3(forceSdfDistance(f.volume, local + vec3(h, 0.0, 0.0)) -
+                         forceSdfDistance(f.volume, local - vec3(h, 0.0, 0.0)),
+                     forceSdfDistance(f.volume, local + vec3(0.0, h, 0.0)) -
+                         forceSdfDistance(f.volume, local - vec3(0.0, h, 0.0)),
+                     forceSdfDistance(f.volume, local + vec3(0.0, 0.0, h)) -
+                         forceSdfDistance(f.volume, local - vec3(0.0, 0.0, h))) / size;
+    if (dot(grad, grad) == 0.0) return;
+    collide(normalize(grad), forceSdfDistance(f.volume, local), f, tickScale, vel);
+  }
+}
+
+// texcoord is pos in the unit volume.
+void applyForceFields(in vec3 pos, in vec3 texcoord, in float tickScale, inout vec3 vel) {
+  if (forceFieldCount == 0u) return;
+
+  ivec3 cell = clamp(ivec3(floor(texcoord * float(kForceFieldBinRes))), ivec3(0),
+                     ivec3(kForceFieldBinRes - 1));
+  uvec2 mask = forceFieldBin[forceFieldBinIndex(cell)];
+  for (int word = 0; word < 2; ++word) {
+    uint bits = mask[word];
+    while (bits != 0u) {
+      int bit = findLSB(bits);
+      bits &= bits - 1u;
+      applyForceField(forceField[word * 32 + bit], pos, tickScale, vel);
+    }
+  }
+}
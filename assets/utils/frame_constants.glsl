@@ -0,0 +1,22 @@
+// Per-frame constants shared by every simulation stage. Mirrors FrameConstants::Data in
+// include/FrameConstants.hpp, std140 rules apply so scalars are packed into the tail of each vec3.
+
+layout(std140, binding = 0) uniform FrameConstants {
+  mat4 worldToVolumeMtx;
+  mat4 worldToUnitVolumeMtx;
+
+  vec3 eyePos;
+  float time;
+  vec3 eyeVel;
+  uint frameId;
+  vec3 viewDir;
+  uint pad0;
+  vec3 volumeBoundsMin;
+  bool compile;
+  vec3 volumeBoundsMax;
+  float sortZMin;
+  uvec3 volumeRes;
+  float sortZMax;
+  vec3 sortAxis;
+  float timeDelta;
+};
@@ -0,0 +1,48 @@
+// Uniform grid over the volume with particles stored cell by cell, rebuilt every frame by
+// NeighbourGrid (include/NeighbourGrid.hpp). To visit the particles around pos:
+//
+//   ivec3 c = gridCellCoord(pos);
+//   for (int i = 0; i < 27; ++i) {
+//     uint cell;
+//     if (!gridCellIndex(c + gridNeighbourOffset(i), cell)) continue;
+//     uvec2 range = gridCellRange[cell];
+//     for (uint j = range.x; j < range.x + range.y; ++j) {
+//       GridEntry n = gridEntry[j];
+//       ...
+//     }
+//   }
+//
+// Entries are positions from when the grid was built, n.id indexes the particle buffers. Particles
+// outside the grid bounds aren't in it. Check gridEnabled first, the buffers aren't bound when the
+// grid is switched off.
+
+struct GridEntry {
+  vec3 position;
+  uint id;
+};
+
+layout(std430, binding = 8) buffer GridCellRangeBuffer {
+  uvec2 gridCellRange[]; // First entry, entry count.
+};
+layout(std430, binding = 9) buffer GridEntryBuffer {
+  GridEntry gridEntry[];
+};
+
+uniform bool gridEnabled;
+uniform vec3 gridBoundsMin;
+uniform float gridOneOverCellSize;
+uniform uvec3 gridRes;
+
+ivec3 gridCellCoord(vec3 pos) {
+  return ivec3(floor((pos - gridBoundsMin) * gridOneOverCellSize));
+}
+
+bool gridCellIndex(ivec3 c, out uint index) {
+  if (any(lessThan(c, ivec3(0))) || any(greaterThanEqual(c, ivec3(gridRes)))) return false;
+  index = (uint(c.z) * gridRes.y + uint(c.y)) * gridRes.x + uint(c.x);
+  return true;
+}
+
+ivec3 gridNeighbourOffset(int i) {
+  return ivec3(i % 3, (i / 3) % 3, i / 9) - 1;
+}
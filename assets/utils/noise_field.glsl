@@ -0,0 +1,32 @@
+// NOTE(ryan): The two octave noise derivative field that drives the particles. Shared between the
+// update shader and noise_bake_cs.glsl so the baked volume can't drift from the analytic version.
+// Expects utils/noise.glsl to be included first.
+
+const vec3 kNoiseFieldScale = vec3(2.0, 2.01, 2.05);
+const vec3 kNoiseFieldOffset = vec3(443.897, 441.423, 437.195);
+const vec3 kNoiseFieldScroll = vec3(0.05, 0.07, 0.09);
+
+vec3 noiseFieldAnalytic(in vec3 pos, in float time) {
+  vec3 q = kNoiseFieldScale * pos + kNoiseFieldOffset + vec3(time) * kNoiseFieldScroll;
+  return SimplexPerlin3D_Deriv(q).xyz + 0.7 * SimplexPerlin3D_Deriv(q * 5.01).xyz;
+}
+
+
+uniform bool noiseFieldVolume;
+uniform sampler3D noiseFieldTex;
+uniform mat4 worldToNoiseFieldMtx;
+uniform float noiseFieldTime;
+
+// Time only translates the field, so a volume baked at noiseFieldTime can be sampled at any later
+// time by looking up the position that has since scrolled into place. Falls back to evaluating the
+// noise outside the baked bounds.
+vec3 noiseField(in vec3 pos, in float time) {
+  if (noiseFieldVolume) {
+    vec3 scrolled = pos + (time - noiseFieldTime) * kNoiseFieldScroll / kNoiseFieldScale;
+    vec3 texcoord = vec3(worldToNoiseFieldMtx * vec4(scrolled, 1.0));
+    if (all(greaterThanEqual(texcoord, vec3(0.0))) && all(lessThanEqual(texcoord, vec3(1.0)))) {
+      return texture(noiseFieldTex, texcoord).xyz;
+    }
+  }
+  return noiseFieldAnalytic(pos, time);
+}
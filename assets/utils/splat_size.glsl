@@ -0,0 +1,13 @@
+// Pixel size limits shared by the point and billboard render paths.
+
+uniform float minPointSize, maxPointSize;
+
+// Clamps a splat's diameter in pixels. Splats smaller than minPointSize are drawn at that size with
+// their (premultiplied) colour scaled by the lost area, so they fade out rather than shimmer.
+float clampSplatSize(float size, inout vec4 color) {
+  if (size < minPointSize) {
+    color *= (size * size) / (minPointSize * minPointSize);
+    size = minPointSize;
+  }
+  return min(size, maxPointSize);
+}
@@ -0,0 +1,39 @@
+// Screen tiles for the compute splat rasteriser, built every frame by SplatRasterizer
+// (include/SplatRasterizer.hpp). Splats are identified by their rank, front to back: rank r is
+// sorted particle aliveCount - 1 - r, since the radix sort leaves the live particles back to front.
+
+const uint kTileSize = 16u;
+
+// Only .x is used, RadixSort's scan works on uvec4s.
+layout(std430, binding = 14) buffer TileCountBuffer {
+  uvec4 tileCount[];
+};
+layout(std430, binding = 15) buffer TileRangeBuffer {
+  uvec2 tileRange[]; // First entry, entry count.
+};
+// Coherent since tile_raster_cs sorts each tile's entries in place across its work group.
+layout(std430, binding = 16) coherent buffer TileEntryBuffer {
+  uint tileEntry[];
+};
+
+uniform mat4 modelViewProjection;
+uniform vec2 viewportSize;
+uniform uvec2 tileRes;
+uniform float pointSize;
+uniform float cullDistance;
+
+// Sized like render_vs.glsl, the radius is in pixels. False if the splat is culled.
+bool projectSplat(Particle p, out vec2 centre, out float radius) {
+  vec4 clipPos = modelViewProjection * vec4(p.position, 1.0);
+  centre = (clipPos.xy / clipPos.w * 0.5 + 0.5) * viewportSize;
+  radius = 0.5 * pointSize * p.scale / clipPos.w;
+  return p.scale > 0.0 && clipPos.w > 0.0 && clipPos.w < cullDistance;
+}
+
+// Inclusive range of tiles the splat touches. False if it's entirely off screen.
+bool getSplatTiles(vec2 centre, float radius, out uvec2 tileMin, out uvec2 tileMax) {
+  vec2 lo = centre - radius, hi = centre + radius;
+  tileMin = uvec2(max(lo, vec2(0.0))) / kTileSize;
+  tileMax = min(uvec2(max(hi, vec2(0.0))) / kTileSize, tileRes - 1u);
+  return all(greaterThanEqual(hi, vec2(0.0))) && all(lessThan(lo, viewportSize));
+}
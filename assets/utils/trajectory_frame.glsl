@@ -0,0 +1,16 @@
+// One frame of a baked trajectory cache. Mirrors the lane layout in src/TrajectoryCache.cpp.
+// Every particle is 8 lanes of 16 bits: position as unorm16 over the cache's bounds, then scale
+// and rgba as half floats. The frame is plane-major, lane 0 of every particle, then lane 1 and so
+// on, so the encoder sees runs of like values. Neighbouring particles share a word.
+
+const uint kTrajectoryLaneCount = 8u;
+
+layout(std430, binding = 18) buffer TrajectoryFrameBuffer {
+  uint trajectoryFrame[];
+};
+
+uniform vec3 trajectoryBoundsMin, trajectoryBoundsSize;
+
+uint getTrajectoryWordIndex(uint lane, uint pair) {
+  return lane * (PARTICLE_COUNT / 2u) + pair;
+}
@@ -0,0 +1,29 @@
+// The fitted simulation volume and the reduction that feeds it. Mirrors VolumeBoundsFitter::Bounds
+// in include/VolumeBoundsFitter.hpp. The matrices lead so FrameConstants::copyVolumeFrom can copy
+// them straight over the frame constants' own.
+
+layout(std430, binding = 17) buffer VolumeBoundsBuffer {
+  mat4 fitWorldToVolumeMtx;
+  mat4 fitWorldToUnitVolumeMtx;
+  vec4 fitBoundsMin;
+  vec4 fitBoundsMax;
+  uvec4 reduceMin;
+  uvec4 reduceMax;
+};
+
+// Order preserving float <-> uint mapping, so the reduction can use integer atomicMin/atomicMax on
+// positions of either sign.
+uint orderedFloatBits(float f) {
+  uint u = floatBitsToUint(f);
+  return (u & 0x80000000u) != 0u ? ~u : u | 0x80000000u;
+}
+uvec3 orderedFloatBits(vec3 v) {
+  return uvec3(orderedFloatBits(v.x), orderedFloatBits(v.y), orderedFloatBits(v.z));
+}
+
+float orderedBitsToFloat(uint u) {
+  return uintBitsToFloat((u & 0x80000000u) != 0u ? u & 0x7fffffffu : ~u);
+}
+vec3 orderedBitsToFloat(uvec3 u) {
+  return vec3(orderedBitsToFloat(u.x), orderedBitsToFloat(u.y), orderedBitsToFloat(u.z));
+}
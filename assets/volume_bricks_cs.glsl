@@ -0,0 +1,27 @@
+#version 430 core
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+layout(r32ui, binding = 0) readonly uniform uimage3D densityImg;
+layout(rg32ui, binding = 1) writeonly uniform uimage3D brickImg;
+
+uniform uint brickSize;
+
+void main() {
+  ivec3 brick = ivec3(gl_GlobalInvocationID);
+  if (any(greaterThanEqual(brick, imageSize(brickImg)))) return;
+
+  uint dMin = 0xffffffffu, dMax = 0u;
+  ivec3 c0 = brick * int(brickSize);
+  for (int z = 0; z < int(brickSize); ++z) {
+    for (int y = 0; y < int(brickSize); ++y) {
+      for (int x = 0; x < int(brickSize); ++x) {
+        uint d = imageLoad(densityImg, c0 + ivec3(x, y, z)).r;
+        dMin = min(dMin, d);
+        dMax = max(dMax, d);
+      }
+    }
+  }
+
+  imageStore(brickImg, brick, uvec4(dMin, dMax, 0u, 0u));
+}
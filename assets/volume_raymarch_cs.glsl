@@ -0,0 +1,72 @@
+#version 430 core
+
+#include "utils/frame_constants.glsl"
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(rgba16f, binding = 0) writeonly uniform image2D outputImg;
+
+// Images rather than samplers, the density volume has linear filtering set which makes it
+// incomplete as an integer texture.
+layout(r32ui, binding = 1) readonly uniform uimage3D densityImg;
+layout(rg32ui, binding = 2) readonly uniform uimage3D brickImg;
+uniform uint brickSize;
+
+uniform mat4 clipToWorldMtx;
+uniform vec3 cameraPos;
+uniform float startDistance;
+uniform float densityScale;
+uniform vec3 volumeColor;
+
+// Slab test against [boxMin, boxMax], returns (tEnter, tExit).
+vec2 intersectBox(vec3 o, vec3 invDir, vec3 boxMin, vec3 boxMax) {
+  vec3 t0 = (boxMin - o) * invDir;
+  vec3 t1 = (boxMax - o) * invDir;
+  vec3 tMin = min(t0, t1), tMax = max(t0, t1);
+  return vec2(max(max(tMin.x, tMin.y), tMin.z), min(min(tMax.x, tMax.y), tMax.z));
+}
+
+void main() {
+  ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+  ivec2 size = imageSize(outputImg);
+  if (any(greaterThanEqual(pixel, size))) return;
+
+  vec2 ndc = (vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0;
+  vec4 farPos = clipToWorldMtx * vec4(ndc, 1.0, 1.0);
+  vec3 dir = normalize(farPos.xyz / farPos.w - cameraPos);
+
+  // March in volume cell coordinates, t stays in world units.
+  mat3 worldToVolume3 = mat3(worldToVolumeMtx);
+  vec3 o = vec3(worldToVolumeMtx * vec4(cameraPos, 1.0));
+  vec3 d = worldToVolume3 * dir;
+  vec3 invD = 1.0 / d;
+
+  vec2 tRange = intersectBox(o, invD, vec3(0.0), vec3(volumeRes));
+  float t = max(tRange.x, startDistance);
+
+  vec3 cellSize = (volumeBoundsMax - volumeBoundsMin) / vec3(volumeRes);
+  float dt = 0.5 * min(min(cellSize.x, cellSize.y), cellSize.z);
+
+  vec4 result = vec4(0.0);
+  while (t < tRange.y && result.a < 0.99) {
+    vec3 v = o + d * t;
+    ivec3 cell = clamp(ivec3(v), ivec3(0), ivec3(volumeRes) - 1);
+    ivec3 brick = cell / int(brickSize);
+
+    if (imageLoad(brickImg, brick).g == 0u) {
+      // Empty brick, jump to where the ray leaves it.
+      vec3 brickMin = vec3(brick * int(brickSize));
+      t = intersectBox(o, invD, brickMin, brickMin + float(brickSize)).y + dt * 0.01;
+      continue;
+    }
+
+    float density = float(imageLoad(densityImg, cell).r);
+    float alpha = 1.0 - exp(-density * densityScale * dt);
+    result.rgb += (1.0 - result.a) * alpha * volumeColor;
+    result.a += (1.0 - result.a) * alpha;
+
+    t += dt;
+  }
+
+  imageStore(outputImg, pixel, result);
+}
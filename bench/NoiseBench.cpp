@@ -0,0 +1,133 @@
+// NOTE(ryan): Measures single-threaded throughput of the CPU SimplexPerlin3D_Deriv kernels, so the
+// numbers are points per second per core. Inputs mimic update_cs.glsl: both noise octaves sampled
+// around a unit sphere with the same scale and offset.
+
+#include "Noise.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace splat;
+
+namespace {
+
+struct Points {
+  std::vector<float> x, y, z;
+
+  explicit Points(size_t count) : x(count), y(count), z(count) {}
+  size_t size() const {
+    return x.size();
+  }
+};
+
+Points makeUpdateShaderPoints(size_t count) {
+  Points points(count);
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+  const float scale[3] = {2.0f, 2.01f, 2.05f};
+  const float hashScale[3] = {443.897f, 441.423f, 437.195f};
+  const float time = 100.0f;
+  const float timeScale[3] = {0.05f, 0.07f, 0.09f};
+
+  for (size_t i = 0; i < count; ++i) {
+    float p[3] = {unit(rng), unit(rng), unit(rng)};
+    float octave = (i & 1) ? 5.01f : 1.0f;
+    float *q[3] = {&points.x[i], &points.y[i], &points.z[i]};
+    for (int k = 0; k < 3; ++k) {
+      *q[k] = (scale[k] * p[k] + hashScale[k] + time * timeScale[k]) * octave;
+    }
+  }
+
+  return points;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+float maxAbsDifference(const Points &a, const Points &b) {
+  float maxDiff = 0.0f;
+  for (size_t i = 0; i < a.size(); ++i) {
+    maxDiff = std::max(maxDiff, std::abs(a.x[i] - b.x[i]));
+    maxDiff = std::max(maxDiff, std::abs(a.y[i] - b.y[i]));
+    maxDiff = std::max(maxDiff, std::abs(a.z[i] - b.z[i]));
+  }
+  return maxDiff;
+}
+
+} // anonymous
+
+
+int main() {
+  // Sized to stay in L2 so we measure the kernel rather than memory bandwidth.
+  const size_t kPointCount = 16 * 1024;
+  const double kMinSeconds = 0.5;
+  const noise::Isa kIsas[] = {noise::Isa::Scalar, noise::Isa::Sse4, noise::Isa::Avx2,
+                              noise::Isa::Avx512};
+  const size_t kIsaCount = sizeof(kIsas) / sizeof(kIsas[0]);
+
+  auto points = makeUpdateShaderPoints(kPointCount);
+  std::vector<Points> results(kIsaCount, Points(kPointCount));
+
+  std::printf("Dispatch selects %s\n\n", noise::getIsaName(noise::detectIsa()));
+  std::printf("%-8s %14s %9s\n", "isa", "Mpoints/s/core", "speedup");
+
+  double scalarRate = 0.0;
+  for (size_t i = 0; i < kIsaCount; ++i) {
+    auto isa = kIsas[i];
+    if (!noise::isSupported(isa)) {
+      std::printf("%-8s %14s\n", noise::getIsaName(isa), "unsupported");
+      continue;
+    }
+
+    auto &result = results[i];
+    auto run = [&] {
+      noise::simplexPerlin3DDeriv(isa, points.x.data(), points.y.data(), points.z.data(),
+                                  result.x.data(), result.y.data(), result.z.data(), kPointCount);
+    };
+
+    run(); // Warm up
+
+    size_t iterations = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed;
+    do {
+      run();
+      ++iterations;
+    } while ((elapsed = secondsSince(start)) < kMinSeconds);
+
+    double rate = double(iterations * kPointCount) / elapsed;
+    if (isa == noise::Isa::Scalar) scalarRate = rate;
+
+    std::printf("%-8s %14.2f %8.2fx\n", noise::getIsaName(isa), rate * 1e-6, rate / scalarRate);
+  }
+
+  // NOTE(ryan): Every pair, not just against scalar, so two wrong paths can't hide behind each
+  // other. All of these should be exactly 0.
+  std::printf("\nmax abs difference\n%-8s", "");
+  for (auto isa : kIsas) std::printf(" %10s", noise::getIsaName(isa));
+  std::printf("\n");
+
+  int mismatches = 0;
+  for (size_t i = 0; i < kIsaCount; ++i) {
+    std::printf("%-8s", noise::getIsaName(kIsas[i]));
+    for (size_t j = 0; j < kIsaCount; ++j) {
+      if (!noise::isSupported(kIsas[i]) || !noise::isSupported(kIsas[j])) {
+        std::printf(" %10s", "-");
+        continue;
+      }
+      float diff = maxAbsDifference(results[i], results[j]);
+      if (diff != 0.0f) ++mismatches;
+      std::printf(" %10g", diff);
+    }
+    std::printf("\n");
+  }
+
+  return mismatches == 0 ? 0 : 1;
+}
@@ -21,7 +21,14 @@ struct Body3 {
 
   void step();
 
+  // The pose t of a step past the current one, if the next step were taken with these impulses.
+  // Doesn't change the body.
+  void extrapolate(float t, const ci::vec3 &impulse, const ci::quat &angularImpulse,
+                   ci::vec3 &pos, ci::quat &ori) const;
+
   void stopAt(const ci::Camera &camera);
 
   void applyTransform(ci::Camera &camera);
+  // Applies the pose alpha of the way from the previous step to the current one.
+  void applyTransform(ci::Camera &camera, float alpha);
 };
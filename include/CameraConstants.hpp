@@ -0,0 +1,39 @@
+#pragma once
+
+#include "UploadRing.hpp"
+
+#include "cinder/Camera.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): The draw camera in a std140 uniform block (utils/camera_constants.glsl), kept apart
+// from FrameConstants so it can be written as late as possible before the draw, from a fresher
+// pose than the one the simulation ran with. Allocated from the same UploadRing.
+class CameraConstants {
+public:
+  static const GLuint kBinding = 1;
+
+  struct Data {
+    mat4 viewProjection;
+    mat4 view;
+    mat4 projection;
+    vec3 eyePos;
+    float pad;
+  };
+
+private:
+  UploadRingRef uploadRing;
+
+public:
+  explicit CameraConstants(const UploadRingRef &uploadRing) : uploadRing(uploadRing) {}
+
+  // Writes the camera into a new allocation and binds it to kBinding.
+  void update(const Camera &camera);
+};
+
+using CameraConstantsRef = std::shared_ptr<CameraConstants>;
+
+} // splat
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ParticleSys.hpp"
+
+#include "cinder/Filesystem.h"
+#include "cinder/gl/gl.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): A checkpoint is the particle buffers, the emitter lists and counters, and the
+// density textures, written as a page sized header followed by the raw blobs. The blobs are laid
+// out exactly as in the staging buffer, so saving is a handful of GPU copies into one persistently
+// mapped buffer and a single write, and restoring is a file mapping handed to one buffer upload.
+//
+// Checkpoints only load into a ParticleSys with the same pool size and volume resolution.
+
+// Copies the state out on construction and writes it on a worker thread once the copies land.
+// Poll isDone() once a frame, it never blocks.
+class CheckpointWriter {
+  GLuint buffer = 0;
+  const uint8_t *mappedPtr = nullptr;
+  GLsizeiptr dataSize = 0;
+  GLsync fence = nullptr;
+
+  std::vector<char> header;
+  std::thread writeThread;
+  std::atomic<bool> written{false};
+
+  void writeThreadFn();
+
+public:
+  fs::path path;
+  // Set if the write failed, valid once isDone() returns true.
+  std::string error;
+
+  CheckpointWriter(const ParticleSys &particleSys, const fs::path &path);
+  ~CheckpointWriter();
+
+  CheckpointWriter(const CheckpointWriter &) = delete;
+  CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+  bool isDone();
+};
+
+using CheckpointWriterRef = std::shared_ptr<CheckpointWriter>;
+
+// Loads a checkpoint in place of the current particles. The subsystems that bake in the volume
+// bounds are rebuilt on next use. Throws std::runtime_error if the file can't be read or doesn't
+// match particleSys.
+void restoreCheckpoint(ParticleSys &particleSys, const fs::path &path);
+
+} // splat
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "cinder/Filesystem.h"
+#include "cinder/gl/GlslProg.h"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Minimal stand-in for gl::GlslProg for compute programs. GlslProg can only be built by
+// compiling source, and we want to be able to create programs from cached binaries (see
+// ProgramCache). Uniforms are set with glProgramUniform so they don't need the program bound.
+class ComputeProg {
+public:
+  struct Format {
+    fs::path path;
+    std::vector<std::pair<std::string, std::string>> defines;
+
+    Format &compute(const fs::path &p) {
+      path = p;
+      return *this;
+    }
+    Format &define(const std::string &name, const std::string &value = "") {
+      defines.emplace_back(name, value);
+      return *this;
+    }
+  };
+
+private:
+  GLuint handle;
+  mutable std::unordered_map<std::string, GLint> uniformLocations;
+
+  void setUniform(GLint loc, bool value) const;
+  void setUniform(GLint loc, int value) const;
+  void setUniform(GLint loc, uint32_t value) const;
+  void setUniform(GLint loc, float value) const;
+  void setUniform(GLint loc, const vec2 &value) const;
+  void setUniform(GLint loc, const vec3 &value) const;
+  void setUniform(GLint loc, const vec4 &value) const;
+  void setUniform(GLint loc, const uvec2 &value) const;
+  void setUniform(GLint loc, const ivec3 &value) const;
+  void setUniform(GLint loc, const uvec3 &value) const;
+  void setUniform(GLint loc, const mat4 &value) const;
+
+public:
+  // Takes ownership of a linked program.
+  explicit ComputeProg(GLuint handle);
+  ~ComputeProg();
+
+  ComputeProg(const ComputeProg &) = delete;
+  ComputeProg &operator=(const ComputeProg &) = delete;
+
+  GLuint getHandle() const {
+    return handle;
+  }
+
+  void bind() const;
+
+  GLint getUniformLocation(const std::string &name) const;
+
+  template <typename T>
+  void uniform(const std::string &name, const T &value) const {
+    setUniform(getUniformLocation(name), value);
+  }
+};
+
+using ComputeProgRef = std::shared_ptr<ComputeProg>;
+
+} // splat
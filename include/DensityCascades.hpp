@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "Emitters.hpp"
+#include "ProgramCache.hpp"
+
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Texture.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Nested density volumes centred on the eye (utils/density_cascades.glsl), so particles
+// far outside volumeBounds still see density without a huge fixed volume. Every cascade has the
+// same resolution and twice the cell size of the one inside it. Origins snap to whole cells and
+// texels are addressed toroidally, so moving the camera never moves a cell to a different texel.
+//
+// Density here is rebuilt from the particles every frame like the fixed volume, so each frame
+// clears whole cascades rather than just the slabs the camera uncovered.
+class DensityCascades {
+public:
+  static const int kMaxCascades = 4;
+
+  ComputeProgRef accumProg, gradProg;
+  gl::Texture3dRef densityTextures[kMaxCascades], gradTextures[kMaxCascades];
+
+  ivec3 originCells[kMaxCascades];
+  int count, res;
+  float baseCellSize;
+  uint32_t workGroupSize;
+
+  void setUniforms(const ComputeProgRef &prog) const;
+
+public:
+  // res has to be a power of two, the shaders wrap cells with a mask. Throws std::invalid_argument.
+  DensityCascades(const ProgramCacheRef &programCache, int res, float baseCellSize,
+                  uint32_t workGroupSize);
+
+  // Recentres the first count cascades on eyePos and rebuilds them from the live particles.
+  void build(int count, const vec3 &eyePos, const gl::SsboRef &particles,
+             const ParticleEmitters &emitters);
+
+  // Binds the cascades to 2 * kMaxCascades texture units from firstUnit, and sets the cascade*
+  // uniforms declared in density_cascades.glsl.
+  void bind(const ComputeProgRef &prog, uint8_t firstUnit) const;
+  void unbind(uint8_t firstUnit) const;
+
+  // The samplers need units of their own even when there are no cascades, otherwise they'd share
+  // unit 0 with samplers of other types.
+  static void bindDisabled(const ComputeProgRef &prog, uint8_t firstUnit);
+};
+
+using DensityCascadesRef = std::shared_ptr<DensityCascades>;
+
+} // splat
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "ProgramCache.hpp"
+#include "UploadRing.hpp"
+
+#include "cinder/gl/Ssbo.h"
+
+#include <vector>
+
+namespace splat {
+
+using namespace ci;
+
+// Mirrors Emitter in utils/emitter.glsl (std430).
+struct Emitter {
+  // Scales the color's rgb by the density gradient every update.
+  static const uint32_t kDensityTint = 1 << 0;
+  // Outlives leaving the volume, only expiring ends it.
+  static const uint32_t kUnbounded = 1 << 1;
+
+  vec3 position;
+  float radiusMin;
+  vec3 velocity; // Units per second.
+  float radiusMax;
+  vec4 color;
+  float scaleMin, scaleMax;
+  float lifetime; // Seconds.
+  float rate;     // Particles per second.
+
+  // Filled in by ParticleEmitters::emit.
+  uint32_t spawnOffset, spawnCount;
+  float spawnAccum;
+  uint32_t flags;
+};
+
+// NOTE(ryan): Particles are no longer all live all the time. Every slot is either on the dead list
+// or on the alive list, and the lists are maintained on the GPU with atomic counters (see
+// utils/alive_list.glsl). Each frame:
+//
+//   emit()         pops one dead slot per spawn and appends it to the alive list
+//   dispatchAlive  runs the update shader over the alive list only, which passes each particle on
+//                  to the next alive list or back to the dead list
+//   finish()       makes the next list current and writes the indirect dispatch / draw arguments
+//
+// Spawn counts are worked out on the CPU from each emitter's rate, so the emit dispatch is sized
+// to what's spawned. A tick never spawns more than the pool holds, and if the pool runs dry the
+// remaining spawns are dropped.
+//
+// maxAlive caps the live population below the pool size. Lowering it trims the newest particles
+// right away rather than waiting for them to expire, and every indirect dispatch and draw over
+// the alive list shrinks with it.
+class ParticleEmitters {
+public:
+  struct Counters {
+    int32_t deadCount;
+    uint32_t aliveCount, aliveNextCount, pad0;
+    uint32_t aliveDispatch[3], pad1;
+    uint32_t aliveDraw[4];
+    uint32_t aliveQuadDraw[4];
+  };
+
+  static const uint32_t kMaxEmitters = 64;
+
+  std::vector<Emitter> emitters;
+
+  ComputeProgRef emitProg, countersProg, trimProg;
+
+  UploadRingRef uploadRing;
+
+  gl::SsboRef counterBuffer, deadList, lifeBuffer;
+  gl::SsboRef aliveLists[2];
+  int front;
+
+  uint32_t maxParticles, workGroupSize;
+  uint32_t spawnCount;
+  // This tick's descriptors, from the last emit().
+  UploadRing::Allocation emitterData;
+  // Set by prewarm(), cleared by the next emit() or by anything that sets the pool directly.
+  bool prewarmPending;
+
+  // Particles past aliveLimit on the list must already be dead.
+  void updateCounters(bool finish, uint32_t aliveLimit);
+
+public:
+  uint32_t maxAlive;
+  // While false nothing spawns and what comes due is dropped. reset() turns it back on.
+  bool spawning = true;
+
+  ParticleEmitters(const ProgramCacheRef &programCache, const UploadRingRef &uploadRing,
+                   uint32_t maxParticles, uint32_t workGroupSize);
+
+  // Returns every particle to the dead list. Particle data should be reset to zero scale as well.
+  void reset();
+  // Makes the first aliveCount slots live and puts the rest on the dead list, for particles that
+  // were written straight into the buffers rather than emitted. They count as emitterIndex's,
+  // without its flags. Clamped to maxAlive, anything written past that should be zero scale.
+  void resetAlive(uint32_t aliveCount, uint32_t emitterIndex, float lifetime);
+  // Makes the next emit() also spawn each emitter's steady state population, rate * lifetime
+  // particles with ages spread over the lifetime, so the pool starts full and keeps recycling
+  // evenly instead of taking a lifetime to fill.
+  void prewarm();
+
+  void emit(float timeDelta, const gl::SsboRef &particles, const gl::SsboRef &particlesPrev);
+  void finish();
+
+  // Binds the buffers declared in utils/alive_list.glsl.
+  void bindBuffers() const;
+  void unbindBuffers() const;
+  // Binds the descriptors declared in utils/emitter.glsl, as uploaded by the last emit().
+  void bindEmitters() const;
+  void unbindEmitters() const;
+
+  // One invocation per live particle, in work groups of workGroupSize.
+  void dispatchAlive() const;
+  // Draws the first aliveCount vertices, i.e. the live particles once they've been sorted.
+  void drawAlive(GLenum mode) const;
+  // Draws aliveCount instances of a 4 vertex triangle strip.
+  void drawAliveQuads() const;
+};
+
+using ParticleEmittersRef = std::shared_ptr<ParticleEmitters>;
+
+} // splat
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace splat {
+
+// NOTE(ryan): Runs the simulation at a fixed tick rate whatever the display refresh. Each frame
+// banks its duration and runs however many whole ticks are due, possibly none. The remainder is
+// the alpha the renderer uses to interpolate between the last two ticks, so what's drawn trails
+// the simulation by at most one tick. Disabled, every frame is exactly one tick of its own length.
+class FixedTimestep {
+public:
+  double accumulator = 0.0;
+  double tickSeconds = 0.0;
+
+  // Of the last tick run.
+  double time = 0.0;
+  uint32_t tickId = 0;
+
+public:
+  bool enabled = true;
+  float tickRate = 60.0f;
+  // Time beyond this many ticks is dropped, so a slow frame can't snowball into slower ones.
+  int maxTicksPerFrame = 4;
+
+  // Banks frameSeconds and returns the number of ticks due this frame.
+  int beginFrame(double frameSeconds);
+  // Advances time and tickId by one tick.
+  void tick();
+
+  // How far between the last two ticks to draw, in [0, 1].
+  float getAlpha() const;
+};
+
+} // splat
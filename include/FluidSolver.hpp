@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "Emitters.hpp"
+#include "ProgramCache.hpp"
+
+#include "cinder/gl/Query.h"
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Texture.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): PIC/FLIP style incompressible flow on a collocated grid at the density volume's
+// resolution. Each frame particle velocities are splatted to the grid, made divergence free with a
+// red-black Gauss-Seidel pressure solve (warm started from the last frame), and sampled back by
+// the update shader, which blends the projected velocity (PIC) with its own velocity plus the
+// grid's change (FLIP). Collocated central differences make this an approximate projection, which
+// is fine for the look we're after.
+//
+// The residual and GPU time are read back a couple of frames late so the solve never stalls.
+class FluidSolver {
+public:
+  ComputeProgRef p2gProg, gridProg, divergenceProg, pressureProg, residualProg, projectProg;
+
+  gl::SsboRef accumBuffer;
+  gl::Texture3dRef velocityTexture, velocityPrevTexture, divergenceTexture, pressureTexture;
+
+  static const uint32_t kReadbackCount = 3;
+  gl::SsboRef residualBuffers[kReadbackCount];
+  GLsync residualFences[kReadbackCount];
+  uint32_t residualSlot;
+
+  gl::QueryTimeSwappedRef solveTimer;
+
+  uvec3 res;
+  uint32_t workGroupSize;
+
+  void dispatchVolume() const;
+  void readResidual();
+
+public:
+  int iterations = 20;
+  float flipRatio = 0.95f;
+
+  // Latest readback, -1 until one arrives.
+  float residual = -1.0f;
+  double solveMilliseconds = 0.0;
+
+  FluidSolver(const ProgramCacheRef &programCache, const uvec3 &res, uint32_t workGroupSize);
+  ~FluidSolver();
+
+  // Expects the frame's FrameConstants to be bound, the grid covers the volume bounds.
+  void solve(const gl::SsboRef &particles, const gl::SsboRef &particlesPrev,
+             const ParticleEmitters &emitters);
+
+  // Binds the velocity volumes and sets the fluid* uniforms update_cs declares.
+  void bind(const ComputeProgRef &prog, uint8_t velocityUnit, uint8_t velocityPrevUnit) const;
+  void unbind(uint8_t velocityUnit, uint8_t velocityPrevUnit) const;
+};
+
+using FluidSolverRef = std::shared_ptr<FluidSolver>;
+
+} // splat
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "ProgramCache.hpp"
+#include "UploadRing.hpp"
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Texture.h"
+
+#include <functional>
+#include <vector>
+
+namespace splat {
+
+using namespace ci;
+
+// Mirrors ForceField in utils/force_fields.glsl (std430).
+struct ForceField {
+  enum Type : uint32_t { kAttractor, kVortex, kPlane, kSdf };
+
+  vec3 position; // Attractor centre, start of the vortex line, or a point on the plane.
+  Type type;
+  vec3 axis;       // Vortex line from position to its end, or the plane's unit normal.
+  float strength;  // Velocity added per 1/60 s at full weight. Negative attractors repel.
+  float radius;    // Falloff of attractors and vortices, collision margin of planes and SDFs.
+  uint32_t volume; // SDF volume from ForceFields::bakeSdf.
+  uint32_t pad0, pad1;
+
+  // Filled in by ForceFields::update.
+  vec3 boundsMin;
+  uint32_t pad2;
+  vec3 boundsMax;
+  uint32_t pad3;
+};
+
+// NOTE(ryan): External forces as data instead of shader edits. Point attractors, line vortices,
+// collision planes and colliders from baked signed distance volumes are uploaded each tick as an
+// array of descriptors, then binned into a coarse grid over the volume with a bit per field, so
+// the update shader only evaluates the fields whose bounds reach a particle's cell. Planes reach
+// everywhere, the rest cost nothing away from where they act.
+//
+// SDF volumes are baked on the CPU and stacked in one 3D texture, so any field can sample any of
+// them through a single texture unit.
+class ForceFields {
+public:
+  static const uint32_t kMaxFields = 64; // One bit each in a bin.
+  static const uint32_t kBinRes = 16;
+  static const uint32_t kMaxSdfVolumes = 8;
+  static const uint32_t kSdfRes = 32;
+
+  std::vector<ForceField> fields;
+
+private:
+  UploadRingRef uploadRing;
+  ComputeProgRef binProg;
+  gl::SsboRef binBuffer;
+  gl::Texture3dRef sdfTexture;
+  AxisAlignedBox sdfBounds[kMaxSdfVolumes];
+  uint32_t sdfCount;
+
+  UploadRing::Allocation fieldData;
+  uint32_t fieldCount, workGroupSize;
+
+public:
+  ForceFields(const ProgramCacheRef &programCache, const UploadRingRef &uploadRing,
+              uint32_t workGroupSize);
+
+  // Samples distance (negative inside) at kSdfRes^3 cell centres over bounds and returns the new
+  // volume's index. Throws std::runtime_error once all kMaxSdfVolumes are in use.
+  uint32_t bakeSdf(const AxisAlignedBox &bounds,
+                   const std::function<float(const vec3 &)> &distance);
+  const AxisAlignedBox &getSdfBounds(uint32_t volume) const {
+    return sdfBounds[volume];
+  }
+  uint32_t getSdfCount() const {
+    return sdfCount;
+  }
+
+  // Uploads the fields and bins them over the volume in the current frame constants. Fields past
+  // kMaxFields are ignored.
+  void update();
+
+  // Binds the fields and sets the forceField* uniforms declared in force_fields.glsl.
+  void bind(const ComputeProgRef &prog, uint8_t textureUnit) const;
+  void unbind(uint8_t textureUnit) const;
+};
+
+using ForceFieldsRef = std::shared_ptr<ForceFields>;
+
+} // splat
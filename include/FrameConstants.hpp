@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "UploadRing.hpp"
+
+#include "cinder/Vector.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): One std140 uniform block (utils/frame_constants.glsl) holding everything that changes
+// once per frame, instead of a handful of glProgramUniform calls on every program. Each update is
+// a fresh allocation from the shared UploadRing, whose fences keep us from writing over constants
+// the GPU is still reading. With sub-stepping there are several updates a frame, one per
+// simulation tick plus one for the draw.
+class FrameConstants {
+public:
+  static const GLuint kBinding = 0;
+
+  struct Data {
+    mat4 worldToVolumeMtx;
+    mat4 worldToUnitVolumeMtx;
+
+    vec3 eyePos;
+    float time;
+    vec3 eyeVel;
+    uint32_t frameId;
+    vec3 viewDir;
+    uint32_t pad0;
+    vec3 volumeBoundsMin;
+    uint32_t compile;
+    vec3 volumeBoundsMax;
+    float sortZMin;
+    uvec3 volumeRes;
+    float sortZMax;
+    vec3 sortAxis;
+    float timeDelta;
+  };
+
+private:
+  UploadRingRef uploadRing;
+  UploadRing::Allocation current;
+
+public:
+  explicit FrameConstants(const UploadRingRef &uploadRing);
+
+  // Writes data into a new allocation and binds it to kBinding.
+  void update(const Data &data);
+
+  // Overwrites the current allocation's volume members with values computed on the GPU. The
+  // source holds worldToVolumeMtx and worldToUnitVolumeMtx as in Data, followed by the bounds min
+  // and max as vec4s (see utils/volume_bounds.glsl).
+  void copyVolumeFrom(GLuint srcBuffer);
+
+  // Checks the program's FrameConstants block against Data. Throws gl::GlslProgLinkExc on a
+  // mismatch so a bad hot reload is reported like any other shader error.
+  static void verifyLayout(const ComputeProg &prog, const std::string &progName);
+};
+
+using FrameConstantsRef = std::shared_ptr<FrameConstants>;
+
+} // splat
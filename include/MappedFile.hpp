@@ -0,0 +1,51 @@
+#pragma once
+
+#include "cinder/Filesystem.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Read-only memory mapping of a file. Views can cover any byte range, so large files
+// can be walked a window at a time without the whole thing ever being mapped.
+class MappedFile {
+  // Win32 HANDLEs, kept opaque so <windows.h> stays out of the headers.
+  void *file, *mapping;
+
+public:
+  class View {
+    friend class MappedFile;
+
+    // The view starts at the allocation granularity boundary below the requested offset.
+    const void *base = nullptr;
+
+  public:
+    const uint8_t *data = nullptr;
+    uint64_t size = 0;
+
+    View() = default;
+    ~View();
+
+    View(View &&other);
+    View &operator=(View &&other);
+    View(const View &) = delete;
+    View &operator=(const View &) = delete;
+  };
+
+  uint64_t size = 0;
+
+  // Throws std::runtime_error if the file can't be opened or is empty.
+  explicit MappedFile(const fs::path &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Maps [offset, offset + length), clamped to the end of the file. Throws std::runtime_error.
+  View map(uint64_t offset, uint64_t length) const;
+};
+
+} // splat
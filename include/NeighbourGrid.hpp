@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "Emitters.hpp"
+#include "ProgramCache.hpp"
+#include "Sort.hpp"
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/gl/Ssbo.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Uniform grid for neighbour queries (utils/neighbour_grid.glsl). Built each frame by a
+// counting sort over the live particles: count particles per cell, scan the counts with
+// RadixSort's scan programs to get each cell's first entry, then scatter the particles into cell
+// order. Queries touch 27 cells instead of every particle.
+class NeighbourGrid {
+public:
+  ComputeProgRef countProg, cellsProg, reorderProg;
+  RadixSortRef radixSort;
+
+  gl::SsboRef countBuffer, slotBuffer, cellRangeBuffer, entryBuffer;
+
+  AxisAlignedBox bounds;
+  float cellSize;
+  uvec3 res;
+  uint32_t cellCount, scanCount;
+  uint32_t workGroupSize;
+
+  void setGrid(const AxisAlignedBox &bounds, float cellSize);
+
+public:
+  NeighbourGrid(const ProgramCacheRef &programCache, const RadixSortRef &radixSort,
+                uint32_t maxParticles, uint32_t workGroupSize);
+
+  // The cell size is raised if needed so the cell count fits in what RadixSort can scan.
+  void build(const AxisAlignedBox &bounds, float cellSize, const gl::SsboRef &particles,
+             const ParticleEmitters &emitters);
+
+  // Binds the grid buffers and sets the grid* uniforms declared in neighbour_grid.glsl.
+  void bind(const ComputeProgRef &prog) const;
+  void unbind() const;
+};
+
+using NeighbourGridRef = std::shared_ptr<NeighbourGrid>;
+
+} // splat
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+// NOTE(ryan): CPU implementation of SimplexPerlin3D_Deriv from assets/utils/noise.glsl. Points are
+// passed as separate x/y/z arrays so the kernels can vectorize across points rather than across
+// simplex corners. Operations are performed in the same order as the GLSL so results stay within a
+// few ulp of the GPU (the GPU is free to fuse multiply-adds and approximate division, we are not).
+//
+// This header intentionally does not depend on Cinder so the benchmark can be built on its own.
+
+namespace splat {
+namespace noise {
+
+enum class Isa { Scalar, Sse4, Avx2, Avx512 };
+
+// Best instruction set supported by both this build and the running CPU.
+Isa detectIsa();
+bool isSupported(Isa isa);
+const char *getIsaName(Isa isa);
+
+// Evaluates the derivative of 3d simplex noise at count points. Output arrays may alias the input.
+// The first overload dispatches to the best supported instruction set.
+void simplexPerlin3DDeriv(const float *px, const float *py, const float *pz, float *dx, float *dy,
+                          float *dz, size_t count);
+void simplexPerlin3DDeriv(Isa isa, const float *px, const float *py, const float *pz, float *dx,
+                          float *dy, float *dz, size_t count);
+
+} // noise
+} // splat
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "ProgramCache.hpp"
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/gl/Texture.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Bakes the update shader's noise derivative field (utils/noise_field.glsl) into a
+// volume so particles can replace two SimplexPerlin3D_Deriv calls with one texture fetch. The field
+// only translates with time, so a bake stays valid indefinitely and is sampled at a scrolled
+// position. We still rebake a few slices per frame into a back buffer and swap when it completes,
+// to keep the scroll offset (and the region lost off the edge of the volume) small.
+class NoiseField {
+public:
+  ComputeProgRef bakeProg;
+  gl::Texture3dRef textures[2];
+  AxisAlignedBox bakeBounds[2];
+  float bakeTimes[2];
+  int front;
+
+  AxisAlignedBox bounds;
+  uvec3 res;
+  uint32_t slicesPerFrame, bakeSlice;
+  bool baked;
+
+  void bakeSlices(int index, float time, uint32_t sliceBegin, uint32_t sliceEnd);
+
+public:
+  NoiseField(const ProgramCacheRef &programCache, const AxisAlignedBox &bounds, const uvec3 &res,
+             uint32_t slicesPerFrame);
+
+  void update(float time);
+
+  // Takes effect from the next full bake, the front volume keeps the bounds it was baked with.
+  void setBounds(const AxisAlignedBox &bounds) {
+    this->bounds = bounds;
+  }
+
+  // Binds the front volume and sets the noiseField* uniforms declared in noise_field.glsl.
+  void bind(const ComputeProgRef &prog, uint8_t textureUnit) const;
+  void unbind(uint8_t textureUnit) const;
+};
+
+using NoiseFieldRef = std::shared_ptr<NoiseField>;
+
+} // splat
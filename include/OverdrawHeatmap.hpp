@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "ProgramCache.hpp"
+
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/gl/Vao.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Debug instrumentation for particle fill. The particles are drawn a second time with
+// overdraw_fs.glsl, which counts fragments per pixel into an R32UI image, and the counts are shown
+// as a false colour heatmap. A histogram of the counts is reduced on the GPU and read back a couple
+// of frames late (like FluidSolver's residual) for the totals and percentiles.
+class OverdrawHeatmap {
+public:
+  static const uint32_t kBinCount = 1024;
+  static const uint32_t kReadbackCount = 3;
+
+  struct Stats {
+    uint32_t totalLo, totalHi, pad0, pad1;
+    uint32_t histogram[kBinCount];
+  };
+
+  ComputeProgRef statsProg;
+  gl::GlslProgRef heatmapProg;
+  gl::VaoRef emptyVao;
+
+  gl::Texture2dRef countTexture;
+
+  gl::SsboRef statsBuffers[kReadbackCount];
+  GLsync statsFences[kReadbackCount];
+  uint32_t statsSlot;
+
+  void readStats();
+
+public:
+  // Count shown as white, the scale is logarithmic.
+  float heatmapMax = 64.0f;
+
+  // Latest readback. Percentiles are over every pixel in the viewport and saturate at the last
+  // histogram bin.
+  uint64_t totalFragments = 0;
+  float averageDepthComplexity = 0.0f;
+  uint32_t percentile99 = 0, maxCount = 0;
+
+  explicit OverdrawHeatmap(const ProgramCacheRef &programCache);
+  ~OverdrawHeatmap();
+
+  // Clears the counts and binds them to image unit 0 for overdraw_fs.glsl.
+  void begin(const ivec2 &size);
+  // Unbinds the counts and queues the stats reduction.
+  void end();
+
+  // Draws the heatmap over the current framebuffer.
+  void draw();
+};
+
+using OverdrawHeatmapRef = std::shared_ptr<OverdrawHeatmap>;
+
+} // splat
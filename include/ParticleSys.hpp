@@ -1,7 +1,24 @@
 #pragma once
 
+#include "ComputeProg.hpp"
+#include "DensityCascades.hpp"
+#include "Emitters.hpp"
+#include "FluidSolver.hpp"
+#include "ForceFields.hpp"
+#include "FrameConstants.hpp"
+#include "NeighbourGrid.hpp"
+#include "NoiseField.hpp"
+#include "OverdrawHeatmap.hpp"
 #include "Particle.hpp"
+#include "ParticleTarget.hpp"
+#include "PointCloudImport.hpp"
+#include "ProgramCache.hpp"
 #include "Sort.hpp"
+#include "SplatRasterizer.hpp"
+#include "TrajectoryCache.hpp"
+#include "UploadRing.hpp"
+#include "VolumeBoundsFitter.hpp"
+#include "VolumeRenderer.hpp"
 
 #include "cinder/AxisAlignedBox.h"
 #include "cinder/Filesystem.h"
@@ -14,28 +31,134 @@ using namespace ci;
 struct ParticleSys {
   gl::TextureRef particleTexture;
 
-  gl::GlslProgRef particleUpdateProg, particleRenderProg;
-  gl::VboRef particleIds;
-  gl::VaoRef particleAttrs;
+  ProgramCacheRef programCache;
+  UploadRingRef uploadRing;
+  FrameConstantsRef frameConstants;
+  // The last tick's constants, prepareDraw() reuses them with the view it's drawn from.
+  FrameConstants::Data frameData = {};
+
+  ComputeProgRef particleUpdateProg;
+  PendingComputeProgRef particleUpdateProgPending;
+  ComputeProgRef particleInterpolateProg;
+  gl::GlslProgRef particleRenderProg, particleOverdrawProg;
+  gl::GlslProgRef billboardRenderProg, billboardOverdrawProg;
+  gl::VaoRef emptyVao;
   gl::SsboRef particles, particlesPrev, particlesSorted;
 
   gl::Texture3dRef densityTexture, densityGradTexture;
-  gl::GlslProgRef densityAccumProg, densityGradProg, densityDebugRenderProg;
+  ComputeProgRef densityAccumProg, densityGradProg;
+  gl::GlslProgRef densityDebugRenderProg;
+  // Ticks between density updates.
+  int densityInterval = 1;
+
+  // Optional camera-centred cascades, the update shader prefers them over the fixed volume.
+  DensityCascadesRef densityCascades;
+  bool cascadesEnabled = false;
+  int cascadeCount = 3;
 
+  ParticleEmittersRef emitters;
   RadixSortRef radixSort;
 
+  // Attractors, vortices and colliders. Push onto forceFields->fields like emitters.
+  ForceFieldsRef forceFields;
+
+  NoiseFieldRef noiseField;
+  bool noiseFieldEnabled = false;
+
+  NeighbourGridRef neighbourGrid;
+  bool neighbourGridEnabled = false;
+  float neighbourGridCellSize = 0.05f;
+
+  FluidSolverRef fluidSolver;
+  bool fluidEnabled = false;
+
+  // Particles beyond lodDistance from the eye are raymarched through the density volume instead.
+  VolumeRendererRef volumeRenderer;
+  bool lodEnabled = false;
+  float lodDistance = 3.0f;
+
+  // Instanced quads instead of GL_POINTS. Sizes are in pixels, points are also held to the
+  // implementation's point size range.
+  bool billboardsEnabled = false;
+  float minPointSize = 1.0f, maxPointSize = 256.0f;
+  float pointSizeScale = 1.0f;
+  vec2 pointSizeRange;
+
+  SplatRasterizerRef splatRasterizer;
+  bool computeRasterEnabled = false;
+
+  // 1 draws straight into the current framebuffer, 2 or 4 through the reduced resolution target.
+  ParticleTargetRef particleTarget;
+  int particleDownsample = 1;
+
+  OverdrawHeatmapRef overdrawHeatmap;
+
   AxisAlignedBox volumeBounds;
   uvec3 volumeRes;
 
-  bool shaderInit, shaderCompile;
+  // Refits the volume to the live particles on the GPU. volumeBounds follows a few frames late.
+  VolumeBoundsFitterRef boundsFitter;
+  bool dynamicBoundsEnabled = false;
+
+  // Baking records every simulated tick. Playback replaces the simulation with the cache.
+  TrajectoryBakerRef trajectoryBaker;
+  TrajectoryPlayerRef trajectoryPlayer;
+
+  // Simulation pauses while an import streams in, then picks up from the imported points with the
+  // emitters paused, see ParticleEmitters::spawning.
+  PointCloudImportRef pointCloudImport;
+
+  bool shaderCompile;
+  float timePrev = 0.0f;
+  // False until the first tick after construction or reset, which runs with no time step.
+  bool timePrevValid = false;
+
+  ParticleSys(const ProgramCacheRef &programCache, const UploadRingRef &uploadRing);
+
+  // Back to an empty pool and the initial volume, with every stateful subsystem rebuilt on next
+  // use. Settings and programs are kept.
+  void reset();
+
+  // Quantizes positions over the current volumeBounds. Throws std::runtime_error.
+  void startBake(const fs::path &path, float tickRate);
+  // Throws std::runtime_error, leaving the simulation running.
+  void startPlayback(const fs::path &path);
+  // Back to simulating, from an empty pool since the emitter lists don't survive playback.
+  void stopPlayback();
 
-  ParticleSys();
+  // Empties the pool and streams the cloud at path into it over the next few ticks. The volume is
+  // refit to the cloud once it's in. Throws std::runtime_error, leaving the pool as it was.
+  void startImport(const fs::path &path, bool downsample, float pointScale = 1.0f);
+  void finishImport();
 
+  // Runs one simulation tick, or plays the next cached one.
   void update(float time, uint32_t frameId, const vec3 &eyePos, const vec3 &eyeVel,
               const vec3 &viewDirection);
-  void draw(float pointSize);
+  // Sorts the latest tick for drawing from eyePos, alpha of the way from the tick before it. Less
+  // than 1 costs a pass over the whole pool to interpolate.
+  void prepareDraw(float alpha, const vec3 &eyePos, const vec3 &viewDirection);
+  // Fills in the sort range, writes the next frame constants slot and applies the fitted bounds.
+  void updateFrameConstants(FrameConstants::Data &data);
+  // sceneDepth is the depth of whatever the particles are drawn over. Drawing at reduced resolution
+  // needs it, without it particleDownsample is ignored.
+  void draw(float pointSize, const gl::Texture2dRef &sceneDepth = nullptr);
+  void drawParticles(float pointSize);
+  // Draws the live sorted particles with one of the point or billboard programs.
+  void drawSplats(const gl::GlslProgRef &prog, float pointSize);
+  // Counts the fragments drawing the particles at full resolution would shade, as points or
+  // billboards, and shows them as a heatmap over the current framebuffer.
+  void drawOverdraw(float pointSize);
 
+  ComputeProg::Format getUpdateShaderFormat(const fs::path &filepath) const;
+  // Queues a background compile, the running program is kept until the new one is linked.
   void loadUpdateShaderMain(const fs::path &filepath);
+  // Compiles and swaps in the update program right away, for replays. Throws compile errors.
+  void reloadUpdateShader(const fs::path &filepath);
+  // Swaps in the pending update program if it's ready. Returns true on swap, throws compile errors.
+  bool swapUpdateShader();
+  bool isUpdateShaderPending() const {
+    return particleUpdateProgPending != nullptr;
+  }
 };
 
 } // splat
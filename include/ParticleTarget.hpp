@@ -0,0 +1,43 @@
+#pragma once
+
+#include "cinder/gl/Fbo.h"
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Vao.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Reduced resolution render target for the particles. They're soft blobs, so blending
+// them at half or quarter resolution loses little and saves most of the fill. The scene depth is
+// downsampled into the target's depth buffer first so particles are still hidden behind geometry,
+// and the composite is a joint bilateral upsample against the full resolution scene depth.
+class ParticleTarget {
+public:
+  gl::FboRef fbo;
+  gl::GlslProgRef depthDownsampleProg, upsampleProg;
+  gl::VaoRef emptyVao;
+
+  ivec2 windowSize;
+  int downsample;
+
+public:
+  // Relative depth difference at which an upsample tap's weight has halved, roughly.
+  float depthTolerance = 0.02f;
+
+  ParticleTarget();
+
+  // Reallocates the target if the window size or downsample factor changed.
+  void setSize(const ivec2 &windowSize, int downsample);
+
+  // Call with the target's framebuffer and viewport bound. Fills its depth from the scene depth and
+  // clears its colour.
+  void prepare(const gl::Texture2dRef &sceneDepth);
+
+  // Upsamples into the current framebuffer. Expects premultiplied blending.
+  void composite(const gl::Texture2dRef &sceneDepth);
+};
+
+using ParticleTargetRef = std::shared_ptr<ParticleTarget>;
+
+} // splat
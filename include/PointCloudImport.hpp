@@ -0,0 +1,74 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Particle.hpp"
+#include "UploadRing.hpp"
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/Filesystem.h"
+#include "cinder/gl/gl.h"
+
+#include <limits>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Streams a point cloud into the particle buffer. Reads binary little endian PLY
+// (vertex x, y, z and optionally red, green, blue, alpha, of any scalar type) or, for any other
+// extension, raw float32 x, y, z triples.
+//
+// The file is mapped a chunk at a time. Each chunk is converted to Particles in parallel straight
+// into an UploadRing region of its own, then copied into place on the GPU, so the copy of one
+// chunk overlaps the reads and conversion of the next. Clouds bigger than the
+// capacity are either thinned out evenly over the whole file or cut off at the capacity.
+class PointCloudImport {
+public:
+  enum PropertyType { kInt8, kUint8, kInt16, kUint16, kInt32, kUint32, kFloat32, kFloat64 };
+
+  struct Property {
+    uint32_t offset = 0;
+    PropertyType type = kFloat32;
+    bool present = false;
+  };
+
+private:
+  MappedFile file;
+  uint64_t dataOffset = 0, stride = 0;
+  Property position[3], color[4];
+
+  // A region per chunk, separate from the shared per-frame ring.
+  UploadRing staging;
+
+  void parsePlyHeader();
+  uint64_t getInputIndex(uint32_t outputIndex) const;
+  void uploadChunk(const gl::SsboRef &particles);
+
+public:
+  fs::path path;
+  uint64_t pointCount = 0;
+  uint32_t importCount = 0, uploadedCount = 0;
+  bool downsample;
+  float pointScale;
+
+  // Of the particles uploaded so far.
+  vec3 boundsMin = vec3(std::numeric_limits<float>::max());
+  vec3 boundsMax = vec3(std::numeric_limits<float>::lowest());
+
+  // Throws std::runtime_error if the file can't be mapped or parsed.
+  PointCloudImport(const fs::path &path, uint32_t capacity, bool downsample, float pointScale);
+
+  // Uploads chunks for a few milliseconds. Returns true once every particle is in the buffer.
+  bool step(const gl::SsboRef &particles);
+
+  AxisAlignedBox getBounds() const {
+    return AxisAlignedBox(boundsMin, boundsMax);
+  }
+  float getProgress() const {
+    return importCount ? float(uploadedCount) / importCount : 1.0f;
+  }
+};
+
+using PointCloudImportRef = std::shared_ptr<PointCloudImport>;
+
+} // splat
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+
+#include "cinder/Filesystem.h"
+#include "cinder/gl/Context.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): A compute program being built on the ProgramCache's worker thread. Poll isReady()
+// once a frame, it never blocks. When it returns true, get() hands over the linked program or
+// rethrows whatever the compile threw. get() may only be called once.
+class PendingComputeProg {
+  friend class ProgramCache;
+
+  ComputeProg::Format format;
+
+  std::atomic<bool> done{false};
+  GLuint handle = 0;
+  GLsync fence = nullptr;
+  std::exception_ptr error;
+
+public:
+  explicit PendingComputeProg(const ComputeProg::Format &format) : format(format) {}
+  ~PendingComputeProg();
+
+  PendingComputeProg(const PendingComputeProg &) = delete;
+  PendingComputeProg &operator=(const PendingComputeProg &) = delete;
+
+  bool isReady();
+  ComputeProgRef get();
+};
+
+using PendingComputeProgRef = std::shared_ptr<PendingComputeProg>;
+
+
+// NOTE(ryan): On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary). The
+// key is a hash of the fully preprocessed source, which includes the defines and every #include,
+// plus the driver's vendor, renderer and version strings. The driver may still reject a binary
+// (e.g. after an update that didn't change the version string), in which case we quietly recompile
+// and overwrite the entry.
+//
+// createComputeAsync() does the same work on a worker thread with its own GL context shared with
+// the main one, so hot reloads don't stall the frame for the length of the compile.
+class ProgramCache {
+  fs::path cacheDirPath;
+  std::string driverId;
+
+  std::thread compileThread;
+  std::mutex compileMutex;
+  std::condition_variable compileCond;
+  std::deque<PendingComputeProgRef> compileQueue;
+  bool compileStop = false;
+
+  GLuint build(const ComputeProg::Format &format);
+  void compileThreadFn(gl::ContextRef context);
+
+public:
+  std::atomic<uint32_t> hitCount{0}, missCount{0};
+  std::atomic<uint64_t> compileMicros{0};
+
+  explicit ProgramCache(const fs::path &cacheDirPath);
+  ~ProgramCache();
+
+  // Throws gl::GlslProgCompileExc or gl::GlslProgLinkExc like gl::GlslProg::create.
+  ComputeProgRef createCompute(const ComputeProg::Format &format);
+  PendingComputeProgRef createComputeAsync(const ComputeProg::Format &format);
+
+  double getCompileSeconds() const {
+    return compileMicros / 1e6;
+  }
+};
+
+using ProgramCacheRef = std::shared_ptr<ProgramCache>;
+
+} // splat
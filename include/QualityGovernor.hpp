@@ -0,0 +1,89 @@
+#pragma once
+
+#include "cinder/gl/gl.h"
+
+#include <string>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Closed loop control of the quality knobs to hold the GPU under a frame budget. Each
+// stage of the frame is bracketed with timestamp queries, read back a few frames late so nothing
+// stalls. (Timestamps rather than elapsed time queries, those can't nest inside FluidSolver's.)
+// When the smoothed total stays over budget for a while one knob steps down, picked by which side
+// of the frame dominates, and when it stays comfortably under budget for longer the most recent
+// step is undone. A cooldown after each step lets the measurements catch up, which together with
+// the gap between the two thresholds keeps it from oscillating. Every step is logged.
+class QualityGovernor {
+public:
+  enum Stage { kStageSimulation, kStageSort, kStageDraw, kStageCount };
+  enum Knob { kKnobParticles, kKnobDensityInterval, kKnobDownsample, kKnobPointSize, kKnobCount };
+
+  static const uint32_t kFrameLatency = 4;
+  static const uint32_t kMaxSteps = 16;
+
+  struct Settings {
+    float particleFraction = 1.0f;
+    int densityInterval = 1;
+    int downsample = 1;
+    float pointSizeScale = 1.0f;
+  };
+
+  // A timestamp at the start of each stage plus one at the end of the frame.
+  GLuint queries[kFrameLatency][kStageCount + 1];
+  uint32_t stagesMarked[kFrameLatency];
+  uint32_t slotFrameIds[kFrameLatency];
+  uint32_t frameSlot;
+
+  int levels[kKnobCount];
+  Knob steps[kMaxSteps];
+  uint32_t stepCount;
+
+  uint32_t overFrames, underFrames, cooldownFrames;
+  bool floorLogged;
+
+  void mark(uint32_t index);
+  bool readTimings();
+  void control();
+  void updateSettings();
+  void log(const std::string &decision);
+
+public:
+  bool enabled = false;
+  float targetMilliseconds = 14.0f;
+  // Step back up once under this fraction of the target.
+  float recoverRatio = 0.7f;
+  int degradeFrames = 10, recoverFrames = 120, cooldown = 30;
+
+  // Counts the frames passed to endFrame, the current frame is frameId.
+  uint32_t frameId = 0;
+
+  // Latest readback, the frame it was measured on, and the total smoothed over a few frames.
+  float stageMilliseconds[kStageCount];
+  uint32_t timedFrameId = 0;
+  float smoothedMilliseconds = 0.0f;
+
+  Settings settings;
+  std::string lastDecision;
+
+  QualityGovernor();
+  ~QualityGovernor();
+
+  QualityGovernor(const QualityGovernor &) = delete;
+  QualityGovernor &operator=(const QualityGovernor &) = delete;
+
+  // Stages must be begun in order, each one ends where the next begins.
+  void beginStage(Stage stage);
+  // Ends the last stage, then reads back an old frame's timings and adjusts settings.
+  void endFrame();
+  // Back to full quality.
+  void reset();
+
+  static const char *getStageName(Stage stage);
+  static const char *getKnobName(Knob knob);
+};
+
+using QualityGovernorRef = std::shared_ptr<QualityGovernor>;
+
+} // splat
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "cinder/Filesystem.h"
+#include "cinder/Quaternion.h"
+#include "cinder/Vector.h"
+
+#include <fstream>
+#include <vector>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Record and replay of everything the simulation takes from outside, so a run can be
+// repeated exactly for benchmarking. The file is a small header then one record per frame, each
+// followed by the ticks it ran. Replay feeds the recorded ticks to ParticleSys::update in place of
+// the live camera and clock, and redoes update shader reloads on the frame they happened.
+
+// One ParticleSys::update.
+struct ReplayTick {
+  float time;
+  uint32_t tickId;
+  vec3 eyePos, eyeVel, viewDir;
+};
+
+struct ReplayFrame {
+  static const uint32_t kShaderReload = 1 << 0;
+
+  uint32_t tickCount, flags;
+  // ParticleSys::prepareDraw arguments.
+  float alpha;
+  vec3 eyePos, viewDir;
+  // The latched draw camera.
+  vec3 drawEyePos;
+  quat drawOrientation;
+};
+
+class ReplayWriter {
+  std::ofstream file;
+
+public:
+  ReplayWriter(const fs::path &path, float tickRate);
+
+  void writeFrame(const ReplayFrame &frame, const std::vector<ReplayTick> &ticks);
+};
+
+class ReplayReader {
+  std::ifstream file;
+
+public:
+  float tickRate;
+  uint32_t frameIndex = 0;
+
+  // Throws std::runtime_error if the file is missing or isn't a recording.
+  explicit ReplayReader(const fs::path &path);
+
+  // False at the end of the recording.
+  bool readFrame(ReplayFrame &frame, std::vector<ReplayTick> &ticks);
+};
+
+// Frame times over a replay, written out as CSV with a summary logged when it finishes. Both are
+// indexed by replay frame. GPU times are read back a few frames late and filled in when they
+// arrive, the last few frames never get one.
+class ReplayStats {
+  void addFrames(uint32_t count);
+
+public:
+  std::vector<float> frameMilliseconds, gpuMilliseconds;
+
+  void setFrame(uint32_t frame, float frameMs);
+  void setGpu(uint32_t frame, float gpuMs);
+  void report(const fs::path &csvPath) const;
+};
+
+using ReplayWriterRef = std::shared_ptr<ReplayWriter>;
+using ReplayReaderRef = std::shared_ptr<ReplayReader>;
+
+} // splat
@@ -1,6 +1,9 @@
 #pragma once
 
-#include "cinder/gl/GlslProg.h"
+#include "ComputeProg.hpp"
+#include "FrameConstants.hpp"
+#include "ProgramCache.hpp"
+
 #include "cinder/gl/Ssbo.h"
 
 #include <vector>
@@ -11,20 +14,28 @@ using namespace ci;
 
 class RadixSort {
 public:
-  gl::GlslProgRef scanProg, scanFirstProg, resolveProg, reorderProg;
+  ComputeProgRef scanProg, scanFirstProg, resolveProg, reorderProg;
 
   gl::SsboRef sortedBuffer, flagsBuffer;
   std::vector<gl::SsboRef> scanBuffers, sumBuffers;
 
   uint32_t elemCount, blockSize, scanLevelCount;
+  GLint bitOffsetLoc;
 
-  void sortBits(GLuint inputBufId, GLuint outputBufId, int bitOffset, const ci::vec3 &axis,
-                float zMin, float zMax);
+  void scanBlockSums(uint32_t blockCount);
+  void sortBits(GLuint inputBufId, GLuint outputBufId, int bitOffset);
 
 public:
-  RadixSort(uint32_t elemCount, uint32_t blockSize);
+  RadixSort(const ProgramCacheRef &programCache, uint32_t elemCount, uint32_t blockSize);
+
+  // Sorts along FrameConstants::sortAxis over [sortZMin, sortZMax], so the frame's constants must
+  // already be bound. The input is only read by the first pass, so it may be the output.
+  void sort(GLuint inputBufId, GLuint outputBufId);
 
-  void sort(GLuint inputBufId, GLuint outputBufId, const ci::vec3 &axis, float zMin, float zMax);
+  // Inclusive scan of count uvec4s, component-wise. count must be a multiple of blockSize and no
+  // more than elemCount. Afterwards element i of the result is scanBuffers[0][i] plus
+  // sumBuffers[0][i / blockSize - 1] (or nothing for the first block), see scan_reorder_cs.glsl.
+  void scan(GLuint inputBufId, uint32_t count);
 };
 
 using RadixSortRef = std::shared_ptr<RadixSort>;
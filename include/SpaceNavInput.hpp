@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SpscQueue.hpp"
+
+#include "cinder/Vector.h"
+
+#include <atomic>
+#include <thread>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Polls the 3D mouse on its own thread so no event is lost between frames and a slow
+// frame can't hold up polling. Every motion or button event is pushed as a timestamped sample for
+// the main thread to drain. The SDK delivers events through the message queue of the thread that
+// owns the window the device was opened with, so the input thread opens it against a message-only
+// window of its own.
+class SpaceNavInput {
+public:
+  struct Sample {
+    double time; // SpaceNavInput::now()
+    vec3 translation, rotation;
+    bool button;
+  };
+
+  static const size_t kQueueCapacity = 1024;
+
+  SpscQueue<Sample, kQueueCapacity> queue;
+  std::thread pollThread;
+  std::atomic<bool> pollStop{false};
+
+  void push(const Sample &sample);
+  void pollThreadFn();
+
+public:
+  std::atomic<bool> connected{false};
+  std::atomic<uint32_t> droppedCount{0};
+
+  SpaceNavInput();
+  ~SpaceNavInput();
+
+  SpaceNavInput(const SpaceNavInput &) = delete;
+  SpaceNavInput &operator=(const SpaceNavInput &) = delete;
+
+  // Main thread only.
+  bool pop(Sample &sample) {
+    return queue.pop(sample);
+  }
+
+  // Clock the samples are stamped with, in seconds.
+  static double now();
+};
+
+using SpaceNavInputRef = std::shared_ptr<SpaceNavInput>;
+
+} // splat
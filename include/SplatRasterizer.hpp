@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "Emitters.hpp"
+#include "ProgramCache.hpp"
+#include "Sort.hpp"
+
+#include "cinder/gl/Ssbo.h"
+#include "cinder/gl/Texture.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Compute alternative to drawing the particles as GL_POINTS. Splats are binned into
+// 16x16 pixel screen tiles (count per tile, scan the counts with RadixSort's scan programs, then
+// scatter), and each tile is blended front to back by one work group in shared memory. A tile stops
+// as soon as all of its pixels are opaque, so dense regions only pay for the front few layers
+// instead of every overlapping splat. There's no hardware point size limit either. The result is
+// premultiplied and composited over the frame like a blended point would be, without a depth test.
+class SplatRasterizer {
+  ComputeProgRef countProg, rangesProg, binProg, rasterProg;
+  RadixSortRef radixSort;
+
+  gl::SsboRef countBuffer, rangeBuffer, entryBuffer;
+  gl::Texture2dRef targetTexture;
+
+  ivec2 viewportSize;
+  uvec2 tileRes;
+  uint32_t tileCount, scanCount, entryCapacity;
+  uint32_t workGroupSize;
+
+  void setViewport(const ivec2 &size);
+  void setUniforms(const ComputeProgRef &prog, float pointSize, float cullDistance) const;
+
+public:
+  SplatRasterizer(const ProgramCacheRef &programCache, const RadixSortRef &radixSort,
+                  uint32_t maxParticles, uint32_t workGroupSize);
+
+  // particlesSorted must hold the live particles sorted back to front, as left by RadixSort.
+  // Splats at or beyond cullDistance are skipped. Uses the current matrices and viewport.
+  void draw(const gl::SsboRef &particlesSorted, const ParticleEmitters &emitters,
+            const gl::TextureRef &splatTexture, float pointSize, float cullDistance);
+};
+
+using SplatRasterizerRef = std::shared_ptr<SplatRasterizer>;
+
+} // splat
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "Emitters.hpp"
+#include "ProgramCache.hpp"
+#include "SpscQueue.hpp"
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/Filesystem.h"
+#include "cinder/gl/gl.h"
+
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): A trajectory cache is every tick of a simulation run, particle by particle, so a
+// fixed sequence can be played back without simulating it again. Each frame is quantized on the
+// GPU to 16 bits a lane (see utils/trajectory_frame.glsl), then delta encoded against the frame
+// before it with zero runs squeezed out, which leaves little more than the particles that moved.
+// Frames are grouped into chunks that start from an empty frame, so playback can seek to any
+// chunk without decoding what comes before it.
+//
+// Positions are quantized over the volume bounds when baking starts. Particles outside them are
+// clamped to the edge.
+
+// Captures the particles after every simulation tick. Encoding and writing happen on a worker
+// thread, capture() only waits if the worker falls kSlotCount frames behind. The file is finished
+// when the baker is destroyed.
+class TrajectoryBaker {
+  static const int kSlotCount = 4;
+
+  ComputeProgRef quantizeProg;
+  uint32_t particleCount, workGroupSize;
+  vec3 boundsMin, boundsSize;
+
+  // Each slot is a persistently mapped frame, owned by the GPU and then the encode thread until
+  // slotBusy is cleared.
+  GLuint slotBuffers[kSlotCount];
+  const uint16_t *slotPtrs[kSlotCount];
+  GLsync slotFences[kSlotCount];
+  std::atomic<bool> slotBusy[kSlotCount];
+  int captureSlot = 0, retireSlot = 0;
+
+  SpscQueue<int, kSlotCount> encodeQueue;
+  std::thread encodeThread;
+  std::atomic<bool> encodeStop{false};
+
+  // Only touched by the encode thread until it's joined.
+  std::ofstream file;
+  std::vector<uint64_t> chunkOffsets;
+  std::vector<uint16_t> prevFrame;
+  std::vector<uint8_t> encoded;
+
+  // Hands frames the GPU is done with to the encode thread, in capture order.
+  void retireSlots(bool wait);
+  void encodeThreadFn();
+
+public:
+  fs::path path;
+  float tickRate;
+
+  std::atomic<uint32_t> frameCount{0};
+  std::atomic<uint64_t> byteCount{0};
+  uint32_t stallCount = 0;
+
+  TrajectoryBaker(const ProgramCacheRef &programCache, const fs::path &path,
+                  uint32_t particleCount, uint32_t workGroupSize, const AxisAlignedBox &bounds,
+                  float tickRate);
+  ~TrajectoryBaker();
+
+  TrajectoryBaker(const TrajectoryBaker &) = delete;
+  TrajectoryBaker &operator=(const TrajectoryBaker &) = delete;
+
+  void capture(const gl::SsboRef &particles);
+};
+
+using TrajectoryBakerRef = std::shared_ptr<TrajectoryBaker>;
+
+
+// Streams a cache back into the particle buffers. A worker thread reads and decodes frames
+// straight into a ring of persistently mapped upload buffers, apply() only dispatches the pass
+// that unpacks the next one. Playback loops back to the first frame at the end.
+class TrajectoryPlayer {
+  static const int kSlotCount = 3;
+  enum SlotState { kSlotFree, kSlotFilled, kSlotInFlight };
+
+  ComputeProgRef dequantizeProg;
+  uint32_t particleCount, workGroupSize;
+  uint32_t chunkFrames;
+  std::vector<uint64_t> chunkOffsets;
+
+  GLuint slotBuffers[kSlotCount];
+  uint16_t *slotPtrs[kSlotCount];
+  GLsync slotFences[kSlotCount];
+  uint32_t slotFrames[kSlotCount];
+  std::atomic<int> slotStates[kSlotCount];
+  int applySlot = 0, decodeSlot = 0;
+
+  std::thread decodeThread;
+  std::atomic<bool> decodeStop{false};
+  // Only touched by the decode thread while it runs.
+  std::ifstream file;
+
+  void startDecode(uint32_t frame);
+  void stopDecode();
+  void decodeThreadFn(uint32_t startFrame);
+
+public:
+  fs::path path;
+  AxisAlignedBox bounds;
+  float tickRate;
+  uint32_t frameCount;
+
+  // The frame in the particle buffers.
+  uint32_t frame = 0;
+  // Ticks the decoder wasn't ready for, the particles hold still for those.
+  uint32_t stallCount = 0;
+  std::atomic<bool> corrupt{false};
+
+  // Throws std::runtime_error if the cache can't be read or was baked with another pool size.
+  TrajectoryPlayer(const ProgramCacheRef &programCache, const fs::path &path,
+                   uint32_t particleCount, uint32_t workGroupSize);
+  ~TrajectoryPlayer();
+
+  TrajectoryPlayer(const TrajectoryPlayer &) = delete;
+  TrajectoryPlayer &operator=(const TrajectoryPlayer &) = delete;
+
+  // Playback carries on from frame. Stalls for a tick or two while the decoder catches up.
+  void seek(uint32_t frame);
+
+  // Writes the next frame to particles, the one it replaces to particlesPrev, and rebuilds the
+  // alive list from it.
+  void apply(const gl::SsboRef &particles, const gl::SsboRef &particlesPrev,
+             ParticleEmitters &emitters);
+};
+
+using TrajectoryPlayerRef = std::shared_ptr<TrajectoryPlayer>;
+
+} // splat
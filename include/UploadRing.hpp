@@ -0,0 +1,78 @@
+#pragma once
+
+#include "cinder/gl/gl.h"
+
+#include <memory>
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): One persistently mapped buffer split into kRegionCount regions, one per frame in
+// flight, that uploads are sub-allocated from. The CPU writes straight into the mapping and the
+// GPU reads the range in place or copies out of it, so nothing goes through a driver side staging
+// copy. endFrame() fences the region just filled and moves on to the next, waiting only if the GPU
+// is still reading it from kRegionCount frames ago.
+//
+// An allocation that doesn't fit in what's left of the region moves on to the next region early.
+// Everything allocated stays valid until kRegionCount - 1 further regions have been started, so a
+// subsystem streaming more than a region a frame should use a ring of its own and consume each
+// allocation right away, rather than push the shared ring's per-frame data out from under it.
+class UploadRing {
+public:
+  static const int kRegionCount = 3;
+
+  struct Allocation {
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+    uint8_t *ptr;
+  };
+
+private:
+  GLuint buffer;
+  uint8_t *mappedPtr;
+  GLsizeiptr regionSize;
+  GLsync fences[kRegionCount];
+  int region;
+  GLsizeiptr head, frameBytes;
+
+  // Fences the current region and waits for the next one to be free.
+  void advance();
+
+public:
+  // Offset alignments for binding allocations as uniform or shader storage buffer ranges.
+  GLsizeiptr uniformAlignment, storageAlignment;
+
+  // Times allocate() or endFrame() had to wait on the GPU, and for how long in total.
+  uint32_t stallCount = 0;
+  double stallSeconds = 0.0;
+  // Allocations that didn't fit in their frame's region.
+  uint32_t overflowCount = 0;
+  GLsizeiptr lastFrameBytes = 0, peakFrameBytes = 0;
+
+  explicit UploadRing(GLsizeiptr regionSize);
+  ~UploadRing();
+
+  UploadRing(const UploadRing &) = delete;
+  UploadRing &operator=(const UploadRing &) = delete;
+
+  // Throws std::length_error if size is bigger than a region.
+  Allocation allocate(GLsizeiptr size, GLsizeiptr alignment);
+  Allocation upload(const void *data, GLsizeiptr size, GLsizeiptr alignment);
+
+  // Call once a frame after everything reading this frame's allocations has been submitted.
+  void endFrame();
+
+  GLsizeiptr getRegionSize() const {
+    return regionSize;
+  }
+  // Of the last frame's region, over 1 when it overflowed.
+  float getOccupancy() const {
+    return float(lastFrameBytes) / float(regionSize);
+  }
+};
+
+using UploadRingRef = std::shared_ptr<UploadRing>;
+
+} // splat
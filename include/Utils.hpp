@@ -3,6 +3,7 @@
 #include "cinder/Filesystem.h"
 #include "cinder/Surface.h"
 #include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Texture.h"
 
 namespace splat {
 
@@ -11,6 +12,13 @@ using namespace ci;
 bool startsWith(const std::string &str, const std::string &prefix);
 int firstIndexOf(const std::string &str, char c);
 
+// 64-bit FNV-1a. Stable across runs and platforms, so it's safe to use for on-disk keys.
+uint64_t hashFnv1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ull);
+
+// Draws texture stretched over the current viewport with the current blending, without a depth
+// test. Used to composite offscreen compute targets over the frame.
+void drawOverViewport(const gl::Texture2dRef &texture);
+
 fs::path saveGrab(const Surface &surf, const fs::path &grabsDirPath);
 
 } // splat
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "Emitters.hpp"
+#include "FrameConstants.hpp"
+#include "ProgramCache.hpp"
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/gl/Ssbo.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Refits the simulation volume to the live particles. Every few frames a min/max
+// reduction over the alive list finds the particle AABB, and a single invocation pass refits the
+// bounds (with hysteresis) and rebuilds the volume matrices in place. The result never leaves the
+// GPU on the simulation's path, apply() copies it over the frame's constants. The CPU copy in
+// bounds is read back a couple of frames late, like FluidSolver's residual, for whatever needs it
+// on the host (the noise field, the neighbour grid and the debug cube).
+class VolumeBoundsFitter {
+public:
+  static const GLuint kBinding = 17;
+  static const uint32_t kReadbackCount = 3;
+
+  // Mirrors utils/volume_bounds.glsl.
+  struct Bounds {
+    mat4 worldToVolumeMtx;
+    mat4 worldToUnitVolumeMtx;
+    vec4 boundsMin, boundsMax;
+    uvec4 reduceMin, reduceMax;
+  };
+
+  ComputeProgRef reduceProg, fitProg;
+  gl::SsboRef boundsBuffer;
+
+  gl::SsboRef readbackBuffers[kReadbackCount];
+  GLsync readbackFences[kReadbackCount];
+  uint32_t readbackSlot;
+
+  uvec3 volumeRes;
+  uint32_t frameCount;
+
+public:
+  // Reduce every interval frames. The fit is a cube padded by margin of the particle extent on
+  // each side, and is only redone when particles escape it or their padded extent drops below
+  // shrinkThreshold of its size.
+  uint32_t interval = 4;
+  float margin = 0.1f;
+  float shrinkThreshold = 0.6f;
+  float minSize = 0.5f;
+
+  // Latest readback.
+  AxisAlignedBox bounds;
+
+  VolumeBoundsFitter(const ProgramCacheRef &programCache, const AxisAlignedBox &initBounds,
+                     const uvec3 &volumeRes, uint32_t workGroupSizeX);
+  ~VolumeBoundsFitter();
+
+  // Overwrites the volume members of the frame's constants with the fitted ones. Call right after
+  // FrameConstants::update.
+  void apply(FrameConstants &frameConstants) const;
+  // Reduces the live particles and refits. Needs the alive list from this frame's update.
+  void fit(const gl::SsboRef &particles, const ParticleEmitters &emitters);
+
+  // Returns true when a newer fit has been read back into bounds. Never blocks.
+  bool readBounds();
+};
+
+using VolumeBoundsFitterRef = std::shared_ptr<VolumeBoundsFitter>;
+
+} // splat
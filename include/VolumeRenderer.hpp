@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ComputeProg.hpp"
+#include "ProgramCache.hpp"
+
+#include "cinder/gl/Texture.h"
+
+namespace splat {
+
+using namespace ci;
+
+// NOTE(ryan): Level-of-detail fallback for the point splats. Raymarches the density volume into a
+// reduced-resolution target and composites it over the frame, so the cost follows the pixel count
+// rather than the particle count. Empty space is skipped with a min/max mip of the density, one
+// texel per brick of cells. Only the part of each ray beyond a start distance is marched, the
+// particles in front of that are still drawn as points.
+class VolumeRenderer {
+public:
+  ComputeProgRef brickProg, raymarchProg;
+  gl::Texture3dRef brickTexture;
+  gl::Texture2dRef targetTexture;
+
+  uvec3 volumeRes;
+  uint32_t brickSize;
+  int downsample;
+
+  float densityScale = 0.5f;
+  vec3 color = vec3(0.05f, 0.04f, 0.04f);
+
+  VolumeRenderer(const ProgramCacheRef &programCache, const uvec3 &volumeRes, uint32_t brickSize,
+                 int downsample);
+
+  // Rebuilds the brick mip, call after the density volume changes.
+  void updateBricks(const gl::Texture3dRef &densityTexture);
+
+  // Uses the current view and projection matrices and viewport. Expects premultiplied blending.
+  void draw(const gl::Texture3dRef &densityTexture, float startDistance);
+};
+
+using VolumeRendererRef = std::shared_ptr<VolumeRenderer>;
+
+} // splat
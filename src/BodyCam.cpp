@@ -25,6 +25,17 @@ void Body3::step() {
   }
 }
 
+void Body3::extrapolate(float t, const vec3 &impulse, const quat &angularImpulse, vec3 &pos,
+                        quat &ori) const {
+  // Same as step().
+  auto vel = (position - positionPrev) * (1.0f - friction) + impulse;
+  pos = position + vel * t;
+
+  auto angularVel = orientation * glm::inverse(orientationPrev);
+  auto next = glm::slerp(angularVel, quat(), angularFriction) * orientation * angularImpulse;
+  ori = glm::slerp(orientation, next, t);
+}
+
 void Body3::stopAt(const Camera &camera) {
   position = positionPrev = camera.getEyePoint();
   orientation = orientationPrev = camera.getOrientation();
@@ -34,3 +45,8 @@ void Body3::applyTransform(ci::Camera &camera) {
   camera.setEyePoint(position);
   camera.setOrientation(orientation);
 }
+
+void Body3::applyTransform(ci::Camera &camera, float alpha) {
+  camera.setEyePoint(glm::mix(positionPrev, position, alpha));
+  camera.setOrientation(glm::slerp(orientationPrev, orientation, alpha));
+}
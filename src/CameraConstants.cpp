@@ -0,0 +1,20 @@
+#include "CameraConstants.hpp"
+
+namespace splat {
+
+static_assert(sizeof(CameraConstants::Data) == 208, "CameraConstants::Data must match std140");
+
+
+void CameraConstants::update(const Camera &camera) {
+  Data data = {};
+  data.view = camera.getViewMatrix();
+  data.projection = camera.getProjectionMatrix();
+  data.viewProjection = data.projection * data.view;
+  data.eyePos = camera.getEyePoint();
+
+  auto allocation = uploadRing->upload(&data, sizeof(Data), uploadRing->uniformAlignment);
+  glBindBufferRange(GL_UNIFORM_BUFFER, kBinding, allocation.buffer, allocation.offset,
+                    sizeof(Data));
+}
+
+} // splat
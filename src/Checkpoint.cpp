@@ -0,0 +1,245 @@
+#include "Checkpoint.hpp"
+#include "MappedFile.hpp"
+
+#include "cinder/Log.h"
+#include "cinder/Thread.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace splat {
+
+namespace {
+
+const uint32_t kMagic = 0x4b435053; // "SPCK"
+const uint32_t kVersion = 1;
+
+// Blob offsets are relative to the end of the header, the same in the file and staging buffer.
+const uint64_t kDataOffset = 4096;
+const uint64_t kBlobAlignment = 256;
+
+enum Blob {
+  kBlobParticles,
+  kBlobParticlesPrev,
+  kBlobLife,
+  kBlobDeadList,
+  kBlobAliveList,
+  kBlobCounters,
+  kBlobDensity,
+  kBlobDensityGrad,
+  kBlobCount
+};
+
+struct Header {
+  uint32_t magic, version;
+  uint32_t particleCount, particleSize;
+  uvec3 volumeRes;
+  uint32_t pad;
+  vec3 volumeBoundsMin, volumeBoundsMax;
+  struct {
+    uint64_t offset, size;
+  } blobs[kBlobCount];
+};
+
+static_assert(sizeof(Header) <= kDataOffset, "Checkpoint header must fit before the blobs");
+
+// Returns the total size of the blobs.
+uint64_t layoutBlobs(uint32_t particleCount, const uvec3 &volumeRes, Header &header) {
+  const uint64_t voxelCount = uint64_t(volumeRes.x) * volumeRes.y * volumeRes.z;
+
+  header.blobs[kBlobParticles].size = particleCount * sizeof(Particle);
+  header.blobs[kBlobParticlesPrev].size = particleCount * sizeof(Particle);
+  header.blobs[kBlobLife].size = particleCount * sizeof(vec4);
+  header.blobs[kBlobDeadList].size = particleCount * sizeof(GLuint);
+  header.blobs[kBlobAliveList].size = particleCount * sizeof(GLuint);
+  header.blobs[kBlobCounters].size = sizeof(ParticleEmitters::Counters);
+  header.blobs[kBlobDensity].size = voxelCount * sizeof(GLuint);           // GL_R32UI
+  header.blobs[kBlobDensityGrad].size = voxelCount * 4 * sizeof(uint16_t); // GL_RGBA16F
+
+  uint64_t offset = 0;
+  for (auto &blob : header.blobs) {
+    blob.offset = offset;
+    offset = (offset + blob.size + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+  }
+  return offset;
+}
+
+// The buffers each blob is copied to and from, in Blob order up to kBlobDensity.
+std::vector<GLuint> getBlobBuffers(const ParticleSys &particleSys) {
+  const auto &emitters = *particleSys.emitters;
+  return {particleSys.particles->getId(), particleSys.particlesPrev->getId(),
+          emitters.lifeBuffer->getId(),   emitters.deadList->getId(),
+          emitters.aliveLists[emitters.front]->getId(), emitters.counterBuffer->getId()};
+}
+
+} // anonymous
+
+
+CheckpointWriter::CheckpointWriter(const ParticleSys &particleSys, const fs::path &path)
+: path(path) {
+  Header h = {};
+  h.magic = kMagic;
+  h.version = kVersion;
+  h.particleCount = particleSys.emitters->maxParticles;
+  h.particleSize = sizeof(Particle);
+  h.volumeRes = particleSys.volumeRes;
+  h.volumeBoundsMin = particleSys.volumeBounds.getMin();
+  h.volumeBoundsMax = particleSys.volumeBounds.getMax();
+  dataSize = GLsizeiptr(layoutBlobs(h.particleCount, h.volumeRes, h));
+
+  header.resize(kDataOffset);
+  std::memcpy(header.data(), &h, sizeof(h));
+
+  // Everything up to now may have written the buffers and textures from a shader.
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT |
+                  GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+  const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glBufferStorage(GL_COPY_WRITE_BUFFER, dataSize, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+  mappedPtr =
+      static_cast<const uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, dataSize, flags));
+
+  auto blobBuffers = getBlobBuffers(particleSys);
+  for (size_t i = 0; i < blobBuffers.size(); ++i) {
+    glBindBuffer(GL_COPY_READ_BUFFER, blobBuffers[i]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, h.blobs[i].offset,
+                        h.blobs[i].size);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+  {
+    gl::ScopedTextureBind scopedTex(particleSys.densityTexture);
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                  reinterpret_cast<void *>(h.blobs[kBlobDensity].offset));
+  }
+  {
+    gl::ScopedTextureBind scopedTex(particleSys.densityGradTexture);
+    glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_HALF_FLOAT,
+                  reinterpret_cast<void *>(h.blobs[kBlobDensityGrad].offset));
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  // The mapping isn't coherent, make the copies visible to it before the fence.
+  glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+  fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  if (writeThread.joinable()) writeThread.join();
+  if (fence) glDeleteSync(fence);
+  if (buffer) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+  }
+}
+
+void CheckpointWriter::writeThreadFn() {
+  ThreadSetup threadSetup;
+
+  std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+  file.write(header.data(), header.size());
+  file.write(reinterpret_cast<const char *>(mappedPtr), dataSize);
+  file.close();
+  if (!file) error = "Failed to write checkpoint " + path.string();
+
+  written = true;
+}
+
+bool CheckpointWriter::isDone() {
+  if (fence) {
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    // The GL buffer stays mapped until the thread is done with it.
+    writeThread = std::thread(&CheckpointWriter::writeThreadFn, this);
+    return false;
+  }
+
+  if (!written) return false;
+  if (writeThread.joinable()) {
+    writeThread.join();
+    if (error.empty()) CI_LOG_I("Wrote checkpoint " << path);
+  }
+  return true;
+}
+
+
+void restoreCheckpoint(ParticleSys &particleSys, const fs::path &path) {
+  MappedFile file(path);
+  auto view = file.map(0, file.size);
+
+  Header h = {};
+  if (view.size < kDataOffset) throw std::runtime_error("Checkpoint is truncated");
+  std::memcpy(&h, view.data, sizeof(h));
+
+  if (h.magic != kMagic || h.version != kVersion) {
+    throw std::runtime_error("Not a version " + std::to_string(kVersion) + " checkpoint");
+  }
+  if (h.particleCount != particleSys.emitters->maxParticles || h.particleSize != sizeof(Particle) ||
+      h.volumeRes != particleSys.volumeRes) {
+    throw std::runtime_error("Checkpoint was saved with a different pool size or volume");
+  }
+
+  Header expected = {};
+  auto dataSize = layoutBlobs(h.particleCount, h.volumeRes, expected);
+  if (std::memcmp(h.blobs, expected.blobs, sizeof(h.blobs)) != 0) {
+    throw std::runtime_error("Checkpoint blob layout doesn't match");
+  }
+  if (view.size < kDataOffset + dataSize) throw std::runtime_error("Checkpoint is truncated");
+
+  // NOTE(ryan): One upload straight out of the mapping, everything else is GPU side copies.
+  GLuint staging = 0;
+  glGenBuffers(1, &staging);
+  glBindBuffer(GL_COPY_READ_BUFFER, staging);
+  glBufferStorage(GL_COPY_READ_BUFFER, GLsizeiptr(dataSize), view.data + kDataOffset, 0);
+
+  auto blobBuffers = getBlobBuffers(particleSys);
+  for (size_t i = 0; i < blobBuffers.size(); ++i) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, blobBuffers[i]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, h.blobs[i].offset, 0,
+                        h.blobs[i].size);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  const auto &res = h.volumeRes;
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging);
+  {
+    gl::ScopedTextureBind scopedTex(particleSys.densityTexture);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, res.x, res.y, res.z, GL_RED_INTEGER,
+                    GL_UNSIGNED_INT, reinterpret_cast<void *>(h.blobs[kBlobDensity].offset));
+  }
+  {
+    gl::ScopedTextureBind scopedTex(particleSys.densityGradTexture);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, res.x, res.y, res.z, GL_RGBA, GL_HALF_FLOAT,
+                    reinterpret_cast<void *>(h.blobs[kBlobDensityGrad].offset));
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  // Deleting is safe right away, GL keeps the storage until the copies are done with it.
+  glDeleteBuffers(1, &staging);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT |
+                  GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+  for (auto &emitter : particleSys.emitters->emitters) emitter.spawnAccum = 0.0f;
+  particleSys.emitters->prewarmPending = false;
+
+  particleSys.volumeBounds = AxisAlignedBox(h.volumeBoundsMin, h.volumeBoundsMax);
+  particleSys.noiseField.reset();
+  particleSys.fluidSolver.reset();
+  particleSys.boundsFitter.reset();
+  particleSys.densityCascades.reset();
+
+  CI_LOG_I("Restored checkpoint " << path);
+}
+
+} // splat
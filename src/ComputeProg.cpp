@@ -0,0 +1,73 @@
+#include "ComputeProg.hpp"
+
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+ComputeProg::ComputeProg(GLuint handle) : handle(handle) {}
+
+ComputeProg::~ComputeProg() {
+  glDeleteProgram(handle);
+}
+
+void ComputeProg::bind() const {
+  // NOTE(ryan): Cinder caches the bound GlslProg and skips redundant binds. Clear its cache first
+  // or the next bind of whatever GlslProg it thinks is current would be dropped.
+  gl::context()->bindGlslProg(nullptr);
+  glUseProgram(handle);
+}
+
+GLint ComputeProg::getUniformLocation(const std::string &name) const {
+  auto it = uniformLocations.find(name);
+  if (it != uniformLocations.end()) return it->second;
+
+  GLint loc = glGetUniformLocation(handle, name.c_str());
+  uniformLocations.emplace(name, loc);
+  return loc;
+}
+
+void ComputeProg::setUniform(GLint loc, bool value) const {
+  glProgramUniform1i(handle, loc, value);
+}
+
+void ComputeProg::setUniform(GLint loc, int value) const {
+  glProgramUniform1i(handle, loc, value);
+}
+
+void ComputeProg::setUniform(GLint loc, uint32_t value) const {
+  glProgramUniform1ui(handle, loc, value);
+}
+
+void ComputeProg::setUniform(GLint loc, float value) const {
+  glProgramUniform1f(handle, loc, value);
+}
+
+void ComputeProg::setUniform(GLint loc, const vec2 &value) const {
+  glProgramUniform2f(handle, loc, value.x, value.y);
+}
+
+void ComputeProg::setUniform(GLint loc, const vec3 &value) const {
+  glProgramUniform3f(handle, loc, value.x, value.y, value.z);
+}
+
+void ComputeProg::setUniform(GLint loc, const vec4 &value) const {
+  glProgramUniform4f(handle, loc, value.x, value.y, value.z, value.w);
+}
+
+void ComputeProg::setUniform(GLint loc, const uvec2 &value) const {
+  glProgramUniform2ui(handle, loc, value.x, value.y);
+}
+
+void ComputeProg::setUniform(GLint loc, const ivec3 &value) const {
+  glProgramUniform3i(handle, loc, value.x, value.y, value.z);
+}
+
+void ComputeProg::setUniform(GLint loc, const uvec3 &value) const {
+  glProgramUniform3ui(handle, loc, value.x, value.y, value.z);
+}
+
+void ComputeProg::setUniform(GLint loc, const mat4 &value) const {
+  glProgramUniformMatrix4fv(handle, loc, 1, GL_FALSE, &value[0][0]);
+}
+
+} // splat
@@ -0,0 +1,133 @@
+#include "DensityCascades.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include <stdexcept>
+
+namespace splat {
+
+static const uint32_t kGroupSizeXYZ = 8;
+
+
+DensityCascades::DensityCascades(const ProgramCacheRef &programCache, int res, float baseCellSize,
+                                 uint32_t workGroupSize)
+: count(0), res(res), baseCellSize(baseCellSize), workGroupSize(workGroupSize) {
+  if (res <= 0 || (res & (res - 1)) != 0) {
+    throw std::invalid_argument("Density cascade resolution must be a power of two");
+  }
+
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize));
+    accumProg = programCache->createCompute(
+        fmt.compute(app::getAssetPath("density_cascade_accum_cs.glsl")));
+  }
+
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_XYZ", std::to_string(kGroupSizeXYZ));
+    gradProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("density_cascade_grad_cs.glsl")));
+  }
+
+  auto fmt = gl::Texture3d::Format()
+                 .immutableStorage()
+                 .internalFormat(GL_R32UI)
+                 .minFilter(GL_NEAREST)
+                 .magFilter(GL_NEAREST)
+                 .wrap(GL_REPEAT);
+  fmt.setMaxMipmapLevel(0);
+
+  auto gradFmt = fmt;
+  gradFmt.setInternalFormat(GL_RGBA16F);
+  gradFmt.setMinFilter(GL_LINEAR);
+  gradFmt.setMagFilter(GL_LINEAR);
+
+  for (int i = 0; i < kMaxCascades; ++i) {
+    densityTextures[i] = gl::Texture3d::create(res, res, res, fmt);
+    gradTextures[i] = gl::Texture3d::create(res, res, res, gradFmt);
+    originCells[i] = ivec3(0);
+  }
+}
+
+void DensityCascades::setUniforms(const ComputeProgRef &prog) const {
+  prog->uniform("cascadeCount", count);
+  prog->uniform("cascadeRes", res);
+  for (int i = 0; i < count; ++i) {
+    auto index = "[" + std::to_string(i) + "]";
+    prog->uniform("cascadeOriginCell" + index, originCells[i]);
+    prog->uniform("cascadeOneOverCellSize" + index, 1.0f / (baseCellSize * float(1 << i)));
+  }
+}
+
+void DensityCascades::build(int count, const vec3 &eyePos, const gl::SsboRef &particles,
+                            const ParticleEmitters &emitters) {
+  this->count = glm::clamp(count, 1, kMaxCascades);
+
+  for (int i = 0; i < this->count; ++i) {
+    float cellSize = baseCellSize * float(1 << i);
+    originCells[i] = ivec3(glm::floor(eyePos / cellSize)) - ivec3(res / 2);
+  }
+
+  // NOTE(ryan): Accumulate particles into each cascade they fall in.
+  {
+    accumProg->bind();
+    setUniforms(accumProg);
+
+    particles->bindBase(0);
+    emitters.bindBuffers();
+
+    for (int i = 0; i < this->count; ++i) {
+      glClearTexImage(densityTextures[i]->getId(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+      accumProg->uniform("cascadeIndex", i);
+      glBindImageTexture(1, densityTextures[i]->getId(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+      emitters.dispatchAlive();
+    }
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    emitters.unbindBuffers();
+    particles->unbindBase();
+  }
+
+  // NOTE(ryan): Density gradients, per cascade.
+  {
+    gradProg->bind();
+    setUniforms(gradProg);
+
+    GLuint groups = (GLuint(res) + kGroupSizeXYZ - 1) / kGroupSizeXYZ;
+    for (int i = 0; i < this->count; ++i) {
+      glBindImageTexture(0, densityTextures[i]->getId(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
+      glBindImageTexture(1, gradTextures[i]->getId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+      glDispatchCompute(groups, groups, groups);
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  }
+}
+
+void DensityCascades::bind(const ComputeProgRef &prog, uint8_t firstUnit) const {
+  bindDisabled(prog, firstUnit);
+  setUniforms(prog);
+
+  for (int i = 0; i < kMaxCascades; ++i) {
+    densityTextures[i]->bind(firstUnit + i);
+    gradTextures[i]->bind(firstUnit + kMaxCascades + i);
+  }
+}
+
+void DensityCascades::unbind(uint8_t firstUnit) const {
+  for (int i = 0; i < kMaxCascades; ++i) {
+    densityTextures[i]->unbind(firstUnit + i);
+    gradTextures[i]->unbind(firstUnit + kMaxCascades + i);
+  }
+}
+
+void DensityCascades::bindDisabled(const ComputeProgRef &prog, uint8_t firstUnit) {
+  prog->uniform("cascadeCount", 0);
+  for (int i = 0; i < kMaxCascades; ++i) {
+    auto index = "[" + std::to_string(i) + "]";
+    prog->uniform("cascadeDensityTex" + index, firstUnit + i);
+    prog->uniform("cascadeGradTex" + index, firstUnit + kMaxCascades + i);
+  }
+}
+
+} // splat
@@ -0,0 +1,229 @@
+#include "Emitters.hpp"
+#include "FrameConstants.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+
+namespace splat {
+
+static_assert(sizeof(Emitter) == 80, "Emitter must match utils/emitter.glsl");
+
+static const GLuint kCounterBinding = 2;
+static const GLuint kAliveListBinding = 3;
+static const GLuint kAliveNextListBinding = 4;
+static const GLuint kDeadListBinding = 5;
+static const GLuint kLifeBinding = 6;
+static const GLuint kEmitterBinding = 7;
+
+
+ParticleEmitters::ParticleEmitters(const ProgramCacheRef &programCache,
+                                   const UploadRingRef &uploadRing, uint32_t maxParticles,
+                                   uint32_t workGroupSize)
+: uploadRing(uploadRing), front(0), maxParticles(maxParticles), workGroupSize(workGroupSize),
+  spawnCount(0), prewarmPending(false), maxAlive(maxParticles) {
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize));
+    emitProg = programCache->createCompute(fmt.compute(app::getAssetPath("emit_cs.glsl")));
+    countersProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("alive_counters_cs.glsl")));
+    trimProg = programCache->createCompute(fmt.compute(app::getAssetPath("alive_trim_cs.glsl")));
+    FrameConstants::verifyLayout(*emitProg, "emit_cs.glsl");
+  }
+
+  counterBuffer = gl::Ssbo::create(sizeof(Counters), nullptr, GL_DYNAMIC_COPY);
+  deadList = gl::Ssbo::create(maxParticles * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+  lifeBuffer = gl::Ssbo::create(maxParticles * sizeof(vec4), nullptr, GL_DYNAMIC_COPY);
+  for (auto &list : aliveLists) {
+    list = gl::Ssbo::create(maxParticles * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+  }
+
+  reset();
+}
+
+void ParticleEmitters::reset() {
+  // Reversed so the lowest slots are handed out first.
+  std::vector<GLuint> ids(maxParticles);
+  std::iota(ids.rbegin(), ids.rend(), 0);
+  deadList->bufferSubData(0, ids.size() * sizeof(GLuint), ids.data());
+
+  Counters counters = {};
+  counters.deadCount = int32_t(maxParticles);
+  counters.aliveDispatch[1] = counters.aliveDispatch[2] = 1;
+  counters.aliveDraw[1] = 1;
+  counters.aliveQuadDraw[0] = 4;
+  counterBuffer->bufferSubData(0, sizeof(Counters), &counters);
+
+  for (auto &emitter : emitters) emitter.spawnAccum = 0.0f;
+  spawning = true;
+}
+
+void ParticleEmitters::resetAlive(uint32_t aliveCount, uint32_t emitterIndex, float lifetime) {
+  aliveCount = std::min(aliveCount, maxAlive);
+
+  std::vector<GLuint> ids(maxParticles);
+  std::iota(ids.begin(), ids.begin() + aliveCount, 0);
+  aliveLists[front]->bufferSubData(0, aliveCount * sizeof(GLuint), ids.data());
+
+  // Reversed so the lowest free slots are handed out first.
+  std::iota(ids.rbegin(), ids.rend() - aliveCount, aliveCount);
+  deadList->bufferSubData(0, (maxParticles - aliveCount) * sizeof(GLuint), ids.data() + aliveCount);
+
+  // Mirrors ParticleLife in utils/alive_list.glsl.
+  float age = 0.0f;
+  GLuint life[4] = {0, 0, emitterIndex, 0};
+  std::memcpy(&life[0], &age, sizeof(float));
+  std::memcpy(&life[1], &lifetime, sizeof(float));
+  lifeBuffer->bind();
+  glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_RGBA32UI, 0, aliveCount * sizeof(vec4),
+                       GL_RGBA_INTEGER, GL_UNSIGNED_INT, life);
+  lifeBuffer->unbind();
+
+  Counters counters = {};
+  counters.deadCount = int32_t(maxParticles - aliveCount);
+  counters.aliveCount = aliveCount;
+  counterBuffer->bufferSubData(0, sizeof(Counters), &counters);
+
+  bindBuffers();
+  updateCounters(false, maxAlive);
+  unbindBuffers();
+
+  for (auto &emitter : emitters) emitter.spawnAccum = 0.0f;
+  prewarmPending = false;
+}
+
+void ParticleEmitters::prewarm() {
+  prewarmPending = true;
+}
+
+void ParticleEmitters::updateCounters(bool finish, uint32_t aliveLimit) {
+  countersProg->bind();
+  countersProg->uniform("finish", finish);
+  countersProg->uniform("maxAlive", aliveLimit);
+
+  glDispatchCompute(1, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void ParticleEmitters::emit(float timeDelta, const gl::SsboRef &particles,
+                            const gl::SsboRef &particlesPrev) {
+  auto emitterCount = std::min(uint32_t(emitters.size()), kMaxEmitters);
+
+  // NOTE(ryan): No more can spawn in a tick than the pool can hold, which also keeps the emit
+  // dispatch inside the work group count limit. Whatever is due past that is dropped rather than
+  // carried, a rate the pool can't sustain would only bank an ever growing backlog.
+  const uint32_t spawnLimit = spawning ? std::min(maxAlive, maxParticles) : 0;
+
+  spawnCount = 0;
+  for (uint32_t i = 0; i < emitterCount; ++i) {
+    auto &emitter = emitters[i];
+    emitter.spawnAccum += emitter.rate * timeDelta;
+    if (prewarmPending) emitter.spawnAccum += emitter.rate * emitter.lifetime;
+    emitter.spawnCount = uint32_t(std::min(emitter.spawnAccum, float(spawnLimit - spawnCount)));
+    emitter.spawnAccum -= std::floor(emitter.spawnAccum);
+    emitter.spawnOffset = spawnCount;
+    spawnCount += emitter.spawnCount;
+  }
+
+  // Uploaded every tick, the update shader reads them too. A blank one stands in when there are
+  // none, so the binding is never empty.
+  static const Emitter kBlank = {};
+  emitterData = uploadRing->upload(emitterCount > 0 ? emitters.data() : &kBlank,
+                                   std::max(emitterCount, 1u) * sizeof(Emitter),
+                                   uploadRing->storageAlignment);
+
+  bindBuffers();
+
+  if (spawnCount > 0) {
+    emitProg->bind();
+    emitProg->uniform("emitterCount", emitterCount);
+    emitProg->uniform("spawnCount", spawnCount);
+    emitProg->uniform("maxAlive", maxAlive);
+    emitProg->uniform("prewarm", prewarmPending);
+
+    particles->bindBase(0);
+    particlesPrev->bindBase(1);
+    bindEmitters();
+
+    glDispatchCompute((spawnCount + workGroupSize - 1) / workGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    unbindEmitters();
+    particlesPrev->unbindBase();
+    particles->unbindBase();
+  }
+  prewarmPending = false;
+
+  if (maxAlive < maxParticles) {
+    // Size the dispatch to include this frame's spawns, then trim.
+    updateCounters(false, maxParticles);
+
+    trimProg->bind();
+    trimProg->uniform("maxAlive", maxAlive);
+    particles->bindBase(0);
+
+    dispatchAlive();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    particles->unbindBase();
+  }
+
+  updateCounters(false, std::min(maxAlive, maxParticles));
+  unbindBuffers();
+}
+
+void ParticleEmitters::finish() {
+  bindBuffers();
+  updateCounters(true, maxParticles);
+  unbindBuffers();
+
+  front = 1 - front;
+}
+
+void ParticleEmitters::bindBuffers() const {
+  counterBuffer->bindBase(kCounterBinding);
+  aliveLists[front]->bindBase(kAliveListBinding);
+  aliveLists[1 - front]->bindBase(kAliveNextListBinding);
+  deadList->bindBase(kDeadListBinding);
+  lifeBuffer->bindBase(kLifeBinding);
+}
+
+void ParticleEmitters::unbindBuffers() const {
+  lifeBuffer->unbindBase();
+  deadList->unbindBase();
+  aliveLists[1 - front]->unbindBase();
+  aliveLists[front]->unbindBase();
+  counterBuffer->unbindBase();
+}
+
+void ParticleEmitters::bindEmitters() const {
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, kEmitterBinding, emitterData.buffer,
+                    emitterData.offset, emitterData.size);
+}
+
+void ParticleEmitters::unbindEmitters() const {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kEmitterBinding, 0);
+}
+
+void ParticleEmitters::dispatchAlive() const {
+  gl::ScopedBuffer scopedIndirect(GL_DISPATCH_INDIRECT_BUFFER, counterBuffer->getId());
+  glDispatchComputeIndirect(offsetof(Counters, aliveDispatch));
+}
+
+void ParticleEmitters::drawAlive(GLenum mode) const {
+  gl::ScopedBuffer scopedIndirect(GL_DRAW_INDIRECT_BUFFER, counterBuffer->getId());
+  glDrawArraysIndirect(mode, reinterpret_cast<const void *>(offsetof(Counters, aliveDraw)));
+}
+
+void ParticleEmitters::drawAliveQuads() const {
+  gl::ScopedBuffer scopedIndirect(GL_DRAW_INDIRECT_BUFFER, counterBuffer->getId());
+  glDrawArraysIndirect(GL_TRIANGLE_STRIP,
+                       reinterpret_cast<const void *>(offsetof(Counters, aliveQuadDraw)));
+}
+
+} // splat
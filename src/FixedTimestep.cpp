@@ -0,0 +1,39 @@
+#include "FixedTimestep.hpp"
+
+#include <algorithm>
+
+namespace splat {
+
+int FixedTimestep::beginFrame(double frameSeconds) {
+  frameSeconds = std::max(frameSeconds, 0.0);
+
+  if (!enabled) {
+    accumulator = 0.0;
+    tickSeconds = frameSeconds;
+    return 1;
+  }
+
+  tickSeconds = 1.0 / tickRate;
+  accumulator += frameSeconds;
+
+  int ticks = int(accumulator / tickSeconds);
+  if (ticks > maxTicksPerFrame) {
+    ticks = maxTicksPerFrame;
+    accumulator = 0.0;
+  } else {
+    accumulator -= ticks * tickSeconds;
+  }
+  return ticks;
+}
+
+void FixedTimestep::tick() {
+  time += tickSeconds;
+  ++tickId;
+}
+
+float FixedTimestep::getAlpha() const {
+  if (!enabled) return 1.0f;
+  return std::min(float(accumulator / tickSeconds), 1.0f);
+}
+
+} // splat
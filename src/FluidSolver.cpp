@@ -0,0 +1,198 @@
+#include "FluidSolver.hpp"
+#include "FrameConstants.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include <cstring>
+
+namespace splat {
+
+static const uint32_t kGroupSizeXYZ = 8;
+static const GLuint kAccumBinding = 12;
+static const GLuint kResidualBinding = 13;
+
+// Fixed point used for the momentum splat, leaves room for ~2000 particles per cell.
+static const float kFixedPointScale = 1048576.0f;
+// Cells with less splatted weight than this are air.
+static const float kMinWeight = 0.01f;
+
+
+FluidSolver::FluidSolver(const ProgramCacheRef &programCache, const uvec3 &res,
+                         uint32_t workGroupSize)
+: residualSlot(0), res(res), workGroupSize(workGroupSize) {
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize));
+    p2gProg = programCache->createCompute(fmt.compute(app::getAssetPath("fluid_p2g_cs.glsl")));
+    FrameConstants::verifyLayout(*p2gProg, "fluid_p2g_cs.glsl");
+  }
+
+  {
+    auto fmt =
+        ComputeProg::Format().define("WORK_GROUP_SIZE_XYZ", std::to_string(kGroupSizeXYZ));
+    std::pair<ComputeProgRef *, const char *> progs[] = {
+        {&gridProg, "fluid_grid_cs.glsl"},         {&divergenceProg, "fluid_divergence_cs.glsl"},
+        {&pressureProg, "fluid_pressure_cs.glsl"}, {&residualProg, "fluid_residual_cs.glsl"},
+        {&projectProg, "fluid_project_cs.glsl"},
+    };
+    for (auto &prog : progs) {
+      *prog.first = programCache->createCompute(fmt.compute(app::getAssetPath(prog.second)));
+      FrameConstants::verifyLayout(**prog.first, prog.second);
+    }
+  }
+
+  uint32_t cellCount = res.x * res.y * res.z;
+  accumBuffer = gl::Ssbo::create(cellCount * 4 * sizeof(GLint), nullptr, GL_DYNAMIC_COPY);
+
+  {
+    auto fmt = gl::Texture3d::Format()
+                   .immutableStorage()
+                   .internalFormat(GL_RGBA32F)
+                   .minFilter(GL_LINEAR)
+                   .magFilter(GL_LINEAR)
+                   .wrap(GL_CLAMP_TO_EDGE);
+    fmt.setMaxMipmapLevel(0);
+
+    velocityTexture = gl::Texture3d::create(res.x, res.y, res.z, fmt);
+    velocityPrevTexture = gl::Texture3d::create(res.x, res.y, res.z, fmt);
+
+    fmt.setInternalFormat(GL_R32F);
+    divergenceTexture = gl::Texture3d::create(res.x, res.y, res.z, fmt);
+    pressureTexture = gl::Texture3d::create(res.x, res.y, res.z, fmt);
+    glClearTexImage(pressureTexture->getId(), 0, GL_RED, GL_FLOAT, nullptr);
+  }
+
+  for (uint32_t i = 0; i < kReadbackCount; ++i) {
+    residualBuffers[i] = gl::Ssbo::create(sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+    residualFences[i] = nullptr;
+  }
+
+  solveTimer = gl::QueryTimeSwapped::create();
+}
+
+FluidSolver::~FluidSolver() {
+  for (auto fence : residualFences) {
+    if (fence) glDeleteSync(fence);
+  }
+}
+
+void FluidSolver::dispatchVolume() const {
+  glDispatchCompute(res.x / kGroupSizeXYZ, res.y / kGroupSizeXYZ, res.z / kGroupSizeXYZ);
+}
+
+void FluidSolver::readResidual() {
+  auto &fence = residualFences[residualSlot];
+  if (!fence) return;
+
+  if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+  glDeleteSync(fence);
+  fence = nullptr;
+
+  // The fence only says the dispatch is done, the shader's atomic writes still need a barrier
+  // before the buffer is read back.
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  GLuint bits = 0;
+  residualBuffers[residualSlot]->bind();
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(bits), &bits);
+  residualBuffers[residualSlot]->unbind();
+  std::memcpy(&residual, &bits, sizeof(residual));
+}
+
+void FluidSolver::solve(const gl::SsboRef &particles, const gl::SsboRef &particlesPrev,
+                        const ParticleEmitters &emitters) {
+  solveTimer->begin();
+
+  // NOTE(ryan): Particles to grid.
+  {
+    accumBuffer->bind();
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32I, GL_RED_INTEGER, GL_INT, nullptr);
+    accumBuffer->unbind();
+
+    p2gProg->bind();
+    p2gProg->uniform("fixedPointScale", kFixedPointScale);
+
+    particles->bindBase(0);
+    particlesPrev->bindBase(1);
+    emitters.bindBuffers();
+    accumBuffer->bindBase(kAccumBinding);
+
+    emitters.dispatchAlive();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    accumBuffer->unbindBase();
+    emitters.unbindBuffers();
+    particlesPrev->unbindBase();
+    particles->unbindBase();
+  }
+
+  glBindImageTexture(0, velocityTexture->getId(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_RGBA32F);
+  glBindImageTexture(1, velocityPrevTexture->getId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+  glBindImageTexture(2, divergenceTexture->getId(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32F);
+  glBindImageTexture(3, pressureTexture->getId(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32F);
+
+  // NOTE(ryan): Normalize the splat into velocities, keeping a copy for FLIP.
+  {
+    gridProg->bind();
+    gridProg->uniform("fixedPointScale", kFixedPointScale);
+    gridProg->uniform("minWeight", kMinWeight);
+
+    accumBuffer->bindBase(kAccumBinding);
+    dispatchVolume();
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    accumBuffer->unbindBase();
+  }
+
+  divergenceProg->bind();
+  dispatchVolume();
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+  pressureProg->bind();
+  GLint parityLoc = pressureProg->getUniformLocation("parity");
+  for (int i = 0; i < iterations; ++i) {
+    for (int parity = 0; parity < 2; ++parity) {
+      glProgramUniform1i(pressureProg->getHandle(), parityLoc, parity);
+      dispatchVolume();
+      glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+  }
+
+  // NOTE(ryan): Residual of the solve, skipped if the readback slot is still in flight.
+  readResidual();
+  if (!residualFences[residualSlot]) {
+    const GLuint zero = 0;
+    residualBuffers[residualSlot]->bufferSubData(0, sizeof(zero), &zero);
+
+    residualProg->bind();
+    residualBuffers[residualSlot]->bindBase(kResidualBinding);
+    dispatchVolume();
+    residualBuffers[residualSlot]->unbindBase();
+
+    residualFences[residualSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    residualSlot = (residualSlot + 1) % kReadbackCount;
+  }
+
+  projectProg->bind();
+  dispatchVolume();
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  solveTimer->end();
+  solveMilliseconds = solveTimer->getElapsedMilliseconds();
+}
+
+void FluidSolver::bind(const ComputeProgRef &prog, uint8_t velocityUnit,
+                       uint8_t velocityPrevUnit) const {
+  velocityTexture->bind(velocityUnit);
+  velocityPrevTexture->bind(velocityPrevUnit);
+  prog->uniform("fluidEnabled", true);
+  prog->uniform("fluidVelocityTex", int(velocityUnit));
+  prog->uniform("fluidVelocityPrevTex", int(velocityPrevUnit));
+  prog->uniform("fluidFlipRatio", flipRatio);
+}
+
+void FluidSolver::unbind(uint8_t velocityUnit, uint8_t velocityPrevUnit) const {
+  velocityPrevTexture->unbind(velocityPrevUnit);
+  velocityTexture->unbind(velocityUnit);
+}
+
+} // splat
@@ -0,0 +1,146 @@
+#include "ForceFields.hpp"
+#include "FrameConstants.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace splat {
+
+static_assert(sizeof(ForceField) == 80, "ForceField must match force_fields.glsl");
+
+static const GLuint kFieldBinding = 19;
+static const GLuint kBinBinding = 20;
+
+
+ForceFields::ForceFields(const ProgramCacheRef &programCache, const UploadRingRef &uploadRing,
+                         uint32_t workGroupSize)
+: uploadRing(uploadRing), sdfCount(0), fieldData(), fieldCount(0), workGroupSize(workGroupSize) {
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize));
+    binProg = programCache->createCompute(fmt.compute(app::getAssetPath("force_bin_cs.glsl")));
+    FrameConstants::verifyLayout(*binProg, "force_bin_cs.glsl");
+  }
+
+  binBuffer = gl::Ssbo::create(kBinRes * kBinRes * kBinRes * sizeof(uvec2), nullptr,
+                               GL_DYNAMIC_COPY);
+
+  {
+    auto fmt = gl::Texture3d::Format()
+                   .immutableStorage()
+                   .internalFormat(GL_R16F)
+                   .minFilter(GL_LINEAR)
+                   .magFilter(GL_LINEAR)
+                   .wrap(GL_CLAMP_TO_EDGE);
+    fmt.setMaxMipmapLevel(0);
+
+    sdfTexture = gl::Texture3d::create(kSdfRes, kSdfRes, kSdfRes * kMaxSdfVolumes, fmt);
+  }
+}
+
+uint32_t ForceFields::bakeSdf(const AxisAlignedBox &bounds,
+                              const std::function<float(const vec3 &)> &distance) {
+  if (sdfCount == kMaxSdfVolumes) throw std::runtime_error("Out of force field SDF volumes");
+
+  // NOTE(ryan): Sampled straight into the upload ring and copied into the volume's slices from
+  // there, so the bake never takes a temporary copy on either side.
+  const GLsizeiptr size = kSdfRes * kSdfRes * kSdfRes * sizeof(float);
+  auto allocation = uploadRing->allocate(size, sizeof(float));
+  float *dst = reinterpret_cast<float *>(allocation.ptr);
+
+  const vec3 cellSize = bounds.getSize() / float(kSdfRes);
+  for (uint32_t z = 0; z < kSdfRes; ++z) {
+    for (uint32_t y = 0; y < kSdfRes; ++y) {
+      for (uint32_t x = 0; x < kSdfRes; ++x) {
+        *dst++ = distance(bounds.getMin() + (vec3(x, y, z) + 0.5f) * cellSize);
+      }
+    }
+  }
+
+  const uint32_t volume = sdfCount++;
+  sdfBounds[volume] = bounds;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, allocation.buffer);
+  {
+    gl::ScopedTextureBind scopedTex(sdfTexture);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, volume * kSdfRes, kSdfRes, kSdfRes, kSdfRes, GL_RED,
+                    GL_FLOAT, reinterpret_cast<void *>(allocation.offset));
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  return volume;
+}
+
+void ForceFields::update() {
+  fieldCount = std::min(uint32_t(fields.size()), kMaxFields);
+  if (fieldCount == 0) return;
+
+  const float kHuge = std::numeric_limits<float>::max();
+  for (uint32_t i = 0; i < fieldCount; ++i) {
+    auto &field = fields[i];
+    switch (field.type) {
+      case ForceField::kAttractor:
+        field.boundsMin = field.position - field.radius;
+        field.boundsMax = field.position + field.radius;
+        break;
+      case ForceField::kVortex:
+        field.boundsMin = glm::min(field.position, field.position + field.axis) - field.radius;
+        field.boundsMax = glm::max(field.position, field.position + field.axis) + field.radius;
+        break;
+      case ForceField::kPlane:
+        field.boundsMin = vec3(-kHuge);
+        field.boundsMax = vec3(kHuge);
+        break;
+      case ForceField::kSdf:
+        // A volume that was never baked gets empty bounds and lands in no bin.
+        if (field.volume < sdfCount) {
+          field.boundsMin = sdfBounds[field.volume].getMin();
+          field.boundsMax = sdfBounds[field.volume].getMax();
+        } else {
+          field.boundsMin = vec3(kHuge);
+          field.boundsMax = vec3(-kHuge);
+        }
+        break;
+    }
+  }
+
+  fieldData = uploadRing->upload(fields.data(), fieldCount * sizeof(ForceField),
+                                 uploadRing->storageAlignment);
+
+  binProg->bind();
+  binProg->uniform("forceFieldCount", fieldCount);
+
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, kFieldBinding, fieldData.buffer, fieldData.offset,
+                    fieldData.size);
+  binBuffer->bindBase(kBinBinding);
+
+  glDispatchCompute((kBinRes * kBinRes * kBinRes + workGroupSize - 1) / workGroupSize, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  binBuffer->unbindBase();
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kFieldBinding, 0);
+}
+
+void ForceFields::bind(const ComputeProgRef &prog, uint8_t textureUnit) const {
+  prog->uniform("forceFieldCount", fieldCount);
+  prog->uniform("forceSdfTex", int(textureUnit));
+  if (fieldCount == 0) return;
+
+  glBindBufferRange(GL_SHADER_STORAGE_BUFFER, kFieldBinding, fieldData.buffer, fieldData.offset,
+                    fieldData.size);
+  binBuffer->bindBase(kBinBinding);
+  sdfTexture->bind(textureUnit);
+}
+
+void ForceFields::unbind(uint8_t textureUnit) const {
+  if (fieldCount == 0) return;
+
+  sdfTexture->unbind(textureUnit);
+  binBuffer->unbindBase();
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kFieldBinding, 0);
+}
+
+} // splat
@@ -0,0 +1,85 @@
+#include "FrameConstants.hpp"
+
+#include <cstddef>
+#include <sstream>
+
+namespace splat {
+
+static_assert(sizeof(FrameConstants::Data) == 240, "FrameConstants::Data must match std140");
+
+#define FRAME_CONSTANT(member) {#member, offsetof(FrameConstants::Data, member)}
+
+static const struct {
+  const char *name;
+  size_t offset;
+} kMembers[] = {
+    FRAME_CONSTANT(worldToVolumeMtx), FRAME_CONSTANT(worldToUnitVolumeMtx),
+    FRAME_CONSTANT(eyePos),           FRAME_CONSTANT(time),
+    FRAME_CONSTANT(eyeVel),           FRAME_CONSTANT(frameId),
+    FRAME_CONSTANT(viewDir),          FRAME_CONSTANT(volumeBoundsMin),
+    FRAME_CONSTANT(compile),          FRAME_CONSTANT(volumeBoundsMax),
+    FRAME_CONSTANT(sortZMin),         FRAME_CONSTANT(volumeRes),
+    FRAME_CONSTANT(sortZMax),         FRAME_CONSTANT(sortAxis),
+    FRAME_CONSTANT(timeDelta),
+};
+
+#undef FRAME_CONSTANT
+
+
+FrameConstants::FrameConstants(const UploadRingRef &uploadRing)
+: uploadRing(uploadRing), current() {}
+
+void FrameConstants::update(const Data &data) {
+  current = uploadRing->upload(&data, sizeof(Data), uploadRing->uniformAlignment);
+  glBindBufferRange(GL_UNIFORM_BUFFER, kBinding, current.buffer, current.offset, sizeof(Data));
+}
+
+void FrameConstants::copyVolumeFrom(GLuint srcBuffer) {
+  const GLintptr dst = current.offset;
+  const GLsizeiptr mtxSize = 2 * sizeof(mat4);
+
+  glBindBuffer(GL_COPY_READ_BUFFER, srcBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, current.buffer);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+                      dst + offsetof(Data, worldToVolumeMtx), mtxSize);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, mtxSize,
+                      dst + offsetof(Data, volumeBoundsMin), sizeof(vec3));
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, mtxSize + sizeof(vec4),
+                      dst + offsetof(Data, volumeBoundsMax), sizeof(vec3));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void FrameConstants::verifyLayout(const ComputeProg &prog, const std::string &progName) {
+  GLuint handle = prog.getHandle();
+
+  GLuint blockIndex = glGetUniformBlockIndex(handle, "FrameConstants");
+  if (blockIndex == GL_INVALID_INDEX) return; // Not used by this program.
+
+  GLint dataSize = 0;
+  glGetActiveUniformBlockiv(handle, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+  if (size_t(dataSize) > sizeof(Data)) {
+    std::ostringstream msg;
+    msg << progName << ": FrameConstants block is " << dataSize << " bytes, expected at most "
+        << sizeof(Data);
+    throw gl::GlslProgLinkExc(msg.str());
+  }
+
+  for (const auto &member : kMembers) {
+    GLuint index = GL_INVALID_INDEX;
+    glGetUniformIndices(handle, 1, &member.name, &index);
+
+    GLint offset = -1;
+    if (index != GL_INVALID_INDEX) {
+      glGetActiveUniformsiv(handle, 1, &index, GL_UNIFORM_OFFSET, &offset);
+    }
+    if (offset != GLint(member.offset)) {
+      std::ostringstream msg;
+      msg << progName << ": FrameConstants." << member.name << " is at offset " << offset
+          << ", expected " << member.offset;
+      throw gl::GlslProgLinkExc(msg.str());
+    }
+  }
+}
+
+} // splat
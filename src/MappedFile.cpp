@@ -0,0 +1,80 @@
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <windows.h>
+
+namespace splat {
+
+MappedFile::MappedFile(const fs::path &path) : file(INVALID_HANDLE_VALUE), mapping(nullptr) {
+  file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+  LARGE_INTEGER fileSize = {};
+  if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+    size = uint64_t(fileSize.QuadPart);
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+
+  if (!mapping) {
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    throw std::runtime_error("Can't map " + path.string());
+  }
+}
+
+MappedFile::~MappedFile() {
+  CloseHandle(mapping);
+  CloseHandle(file);
+}
+
+MappedFile::View MappedFile::map(uint64_t offset, uint64_t length) const {
+  static const uint64_t granularity = [] {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return uint64_t(info.dwAllocationGranularity);
+  }();
+
+  offset = std::min(offset, size);
+  length = std::min(length, size - offset);
+
+  uint64_t baseOffset = offset / granularity * granularity;
+  uint64_t baseLength = offset + length - baseOffset;
+
+  View view;
+  if (length == 0) return view;
+
+  view.base = MapViewOfFile(mapping, FILE_MAP_READ, DWORD(baseOffset >> 32), DWORD(baseOffset),
+                            size_t(baseLength));
+  if (!view.base) throw std::runtime_error("MapViewOfFile failed");
+
+  view.data = static_cast<const uint8_t *>(view.base) + (offset - baseOffset);
+  view.size = length;
+  return view;
+}
+
+
+MappedFile::View::~View() {
+  if (base) UnmapViewOfFile(base);
+}
+
+MappedFile::View::View(View &&other) : base(other.base), data(other.data), size(other.size) {
+  other.base = nullptr;
+  other.data = nullptr;
+  other.size = 0;
+}
+
+MappedFile::View &MappedFile::View::operator=(View &&other) {
+  if (this != &other) {
+    if (base) UnmapViewOfFile(base);
+    base = other.base;
+    data = other.data;
+    size = other.size;
+    other.base = nullptr;
+    other.data = nullptr;
+    other.size = 0;
+  }
+  return *this;
+}
+
+} // splat
@@ -0,0 +1,140 @@
+#include "NeighbourGrid.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+static const GLuint kCellRangeBinding = 8;
+static const GLuint kEntryBinding = 9;
+static const GLuint kCountBinding = 10;
+static const GLuint kSlotBinding = 11;
+
+
+NeighbourGrid::NeighbourGrid(const ProgramCacheRef &programCache, const RadixSortRef &radixSort,
+                             uint32_t maxParticles, uint32_t workGroupSize)
+: radixSort(radixSort), cellSize(0.0f), cellCount(0), scanCount(0),
+  workGroupSize(workGroupSize) {
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize));
+    countProg = programCache->createCompute(fmt.compute(app::getAssetPath("grid_count_cs.glsl")));
+    cellsProg = programCache->createCompute(fmt.compute(app::getAssetPath("grid_cells_cs.glsl")));
+    reorderProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("grid_reorder_cs.glsl")));
+  }
+
+  slotBuffer = gl::Ssbo::create(maxParticles * sizeof(uvec2), nullptr, GL_DYNAMIC_COPY);
+  entryBuffer = gl::Ssbo::create(maxParticles * sizeof(vec4), nullptr, GL_DYNAMIC_COPY);
+}
+
+void NeighbourGrid::setGrid(const AxisAlignedBox &bounds, float cellSize) {
+  const uint32_t maxCells = radixSort->elemCount;
+  const vec3 size = bounds.getSize();
+
+  // Grow the cells until the grid fits.
+  uvec3 res;
+  while (true) {
+    res = uvec3(glm::max(glm::ceil(size / cellSize), vec3(1.0f)));
+    if (res.x * res.y * res.z <= maxCells) break;
+    cellSize *= 1.1f;
+  }
+
+  this->bounds = bounds;
+  this->cellSize = cellSize;
+  this->res = res;
+
+  uint32_t blockSize = radixSort->blockSize;
+  cellCount = res.x * res.y * res.z;
+  scanCount = (cellCount + blockSize - 1) / blockSize * blockSize;
+
+  if (!countBuffer || countBuffer->getSize() < scanCount * sizeof(uvec4)) {
+    countBuffer = gl::Ssbo::create(scanCount * sizeof(uvec4), nullptr, GL_DYNAMIC_COPY);
+    cellRangeBuffer = gl::Ssbo::create(scanCount * sizeof(uvec2), nullptr, GL_DYNAMIC_COPY);
+  }
+}
+
+void NeighbourGrid::bind(const ComputeProgRef &prog) const {
+  cellRangeBuffer->bindBase(kCellRangeBinding);
+  entryBuffer->bindBase(kEntryBinding);
+
+  prog->uniform("gridEnabled", true);
+  prog->uniform("gridBoundsMin", bounds.getMin());
+  prog->uniform("gridOneOverCellSize", 1.0f / cellSize);
+  prog->uniform("gridRes", res);
+}
+
+void NeighbourGrid::unbind() const {
+  entryBuffer->unbindBase();
+  cellRangeBuffer->unbindBase();
+}
+
+void NeighbourGrid::build(const AxisAlignedBox &bounds, float cellSize,
+                          const gl::SsboRef &particles, const ParticleEmitters &emitters) {
+  setGrid(bounds, cellSize);
+
+  // NOTE(ryan): Count particles per cell. The padding up to scanCount has to be zero too.
+  {
+    countBuffer->bind();
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, scanCount * sizeof(uvec4),
+                         GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    countBuffer->unbind();
+
+    bind(countProg);
+    countProg->bind();
+
+    particles->bindBase(0);
+    emitters.bindBuffers();
+    countBuffer->bindBase(kCountBinding);
+    slotBuffer->bindBase(kSlotBinding);
+
+    emitters.dispatchAlive();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    slotBuffer->unbindBase();
+    countBuffer->unbindBase();
+    emitters.unbindBuffers();
+    particles->unbindBase();
+  }
+
+  radixSort->scan(countBuffer->getId(), scanCount);
+
+  // NOTE(ryan): Turn the inclusive scan into each cell's first entry and count.
+  {
+    bind(cellsProg);
+    cellsProg->bind();
+    cellsProg->uniform("cellCount", cellCount);
+    cellsProg->uniform("scanBlockSize", radixSort->blockSize);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, radixSort->scanBuffers.front()->getId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, radixSort->sumBuffers.front()->getId());
+    countBuffer->bindBase(kCountBinding);
+
+    glDispatchCompute((cellCount + workGroupSize - 1) / workGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    countBuffer->unbindBase();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+  }
+
+  // NOTE(ryan): Scatter particles into cell order.
+  {
+    bind(reorderProg);
+    reorderProg->bind();
+
+    particles->bindBase(0);
+    emitters.bindBuffers();
+    slotBuffer->bindBase(kSlotBinding);
+
+    emitters.dispatchAlive();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    slotBuffer->unbindBase();
+    emitters.unbindBuffers();
+    particles->unbindBase();
+  }
+
+  unbind();
+}
+
+} // splat
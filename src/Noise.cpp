@@ -0,0 +1,181 @@
+#include "Noise.hpp"
+#include "NoiseKernel.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace splat {
+namespace noise {
+
+namespace {
+
+struct ScalarLanes {
+  using F = float;
+  using M = bool;
+  static constexpr size_t kWidth = 1;
+
+  static F load(const float *p) {
+    return *p;
+  }
+  static void store(float *p, F v) {
+    *p = v;
+  }
+  static F set1(float x) {
+    return x;
+  }
+  static F add(F a, F b) {
+    return a + b;
+  }
+  static F sub(F a, F b) {
+    return a - b;
+  }
+  static F mul(F a, F b) {
+    return a * b;
+  }
+  static F div(F a, F b) {
+    return a / b;
+  }
+  static F min(F a, F b) {
+    return b < a ? b : a;
+  }
+  static F max(F a, F b) {
+    return a < b ? b : a;
+  }
+  static F floor(F a) {
+    return std::floor(a);
+  }
+  static F sqrt(F a) {
+    return std::sqrt(a);
+  }
+  static M lt(F a, F b) {
+    return a < b;
+  }
+  static F select(M m, F a, F b) {
+    return m ? a : b;
+  }
+};
+
+void simplexPerlin3DDerivScalar(const float *px, const float *py, const float *pz, float *dx,
+                                float *dy, float *dz, size_t count) {
+  detail::simplexPerlin3DDerivBatch<ScalarLanes>(px, py, pz, dx, dy, dz, count);
+}
+
+
+void cpuid(int leaf, int subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, leaf, subleaf);
+  for (int i = 0; i < 4; ++i) regs[i] = uint32_t(r[i]);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+uint64_t xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return (uint64_t(hi) << 32) | lo;
+#endif
+}
+
+bool cpuSupports(Isa isa) {
+  uint32_t leaf0[4], leaf1[4], leaf7[4] = {};
+  cpuid(0, 0, leaf0);
+  cpuid(1, 0, leaf1);
+  if (leaf0[0] >= 7) cpuid(7, 0, leaf7);
+
+  const bool sse41 = (leaf1[2] & (1u << 19)) != 0;
+  const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+  // The OS has to save the YMM (and for AVX-512 the opmask and ZMM) state across context switches.
+  const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+  const bool ymmState = (xcr0 & 0x06) == 0x06;
+  const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+  switch (isa) {
+    case Isa::Scalar:
+      return true;
+    case Isa::Sse4:
+      return sse41;
+    case Isa::Avx2:
+      return ymmState && (leaf7[1] & (1u << 5)) != 0;
+    case Isa::Avx512:
+      return zmmState && (leaf7[1] & (1u << 16)) != 0;
+  }
+  return false;
+}
+
+KernelFn getKernel(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar:
+      return kScalarKernel;
+    case Isa::Sse4:
+      return kSse4Kernel;
+    case Isa::Avx2:
+      return kAvx2Kernel;
+    case Isa::Avx512:
+      return kAvx512Kernel;
+  }
+  return nullptr;
+}
+
+} // anonymous
+
+
+const KernelFn kScalarKernel = &simplexPerlin3DDerivScalar;
+
+
+Isa detectIsa() {
+  static const Isa isa = [] {
+    for (auto isa : {Isa::Avx512, Isa::Avx2, Isa::Sse4}) {
+      if (isSupported(isa)) return isa;
+    }
+    return Isa::Scalar;
+  }();
+  return isa;
+}
+
+bool isSupported(Isa isa) {
+  return getKernel(isa) != nullptr && cpuSupports(isa);
+}
+
+const char *getIsaName(Isa isa) {
+  switch (isa) {
+    case Isa::Scalar:
+      return "Scalar";
+    case Isa::Sse4:
+      return "SSE4.1";
+    case Isa::Avx2:
+      return "AVX2";
+    case Isa::Avx512:
+      return "AVX-512";
+  }
+  return "Unknown";
+}
+
+
+void simplexPerlin3DDeriv(const float *px, const float *py, const float *pz, float *dx, float *dy,
+                          float *dz, size_t count) {
+  static const KernelFn kernel = getKernel(detectIsa());
+  kernel(px, py, pz, dx, dy, dz, count);
+}
+
+void simplexPerlin3DDeriv(Isa isa, const float *px, const float *py, const float *pz, float *dx,
+                          float *dy, float *dz, size_t count) {
+  if (!isSupported(isa)) {
+    throw std::runtime_error(std::string(getIsaName(isa)) + " noise kernel is not supported");
+  }
+  getKernel(isa)(px, py, pz, dx, dy, dz, count);
+}
+
+} // noise
+} // splat
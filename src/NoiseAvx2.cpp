@@ -0,0 +1,69 @@
+// NOTE(ryan): Built with /arch:AVX2 (see the per-file settings in the project). Only reached after
+// Noise.cpp has checked the CPU.
+
+#include "NoiseKernel.hpp"
+
+#include <immintrin.h>
+
+namespace splat {
+namespace noise {
+
+namespace {
+
+struct Avx2Lanes {
+  using F = __m256;
+  using M = __m256;
+  static constexpr size_t kWidth = 8;
+
+  static F load(const float *p) {
+    return _mm256_loadu_ps(p);
+  }
+  static void store(float *p, F v) {
+    _mm256_storeu_ps(p, v);
+  }
+  static F set1(float x) {
+    return _mm256_set1_ps(x);
+  }
+  static F add(F a, F b) {
+    return _mm256_add_ps(a, b);
+  }
+  static F sub(F a, F b) {
+    return _mm256_sub_ps(a, b);
+  }
+  static F mul(F a, F b) {
+    return _mm256_mul_ps(a, b);
+  }
+  static F div(F a, F b) {
+    return _mm256_div_ps(a, b);
+  }
+  static F min(F a, F b) {
+    return _mm256_min_ps(a, b);
+  }
+  static F max(F a, F b) {
+    return _mm256_max_ps(a, b);
+  }
+  static F floor(F a) {
+    return _mm256_floor_ps(a);
+  }
+  static F sqrt(F a) {
+    return _mm256_sqrt_ps(a);
+  }
+  static M lt(F a, F b) {
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+  }
+  static F select(M m, F a, F b) {
+    return _mm256_blendv_ps(b, a, m);
+  }
+};
+
+void simplexPerlin3DDerivAvx2(const float *px, const float *py, const float *pz, float *dx,
+                              float *dy, float *dz, size_t count) {
+  detail::simplexPerlin3DDerivBatch<Avx2Lanes>(px, py, pz, dx, dy, dz, count);
+}
+
+} // anonymous
+
+const KernelFn kAvx2Kernel = &simplexPerlin3DDerivAvx2;
+
+} // noise
+} // splat
@@ -0,0 +1,83 @@
+// NOTE(ryan): MSVC exposes the AVX-512 intrinsics without any /arch flag from VS2017 15.3 on, other
+// compilers need this file built with -mavx512f. Only reached after Noise.cpp has checked the CPU.
+//
+// NoiseBench builds with v141 and has this kernel. SplatTest stays on v140 to match the Cinder
+// libs, so there the kernel compiles out, isSupported(Avx512) is false and dispatch picks AVX2.
+
+#include "NoiseKernel.hpp"
+
+#if defined(__AVX512F__) || (defined(_MSC_VER) && _MSC_VER >= 1911)
+#define SPLAT_NOISE_AVX512 1
+#include <immintrin.h>
+#endif
+
+namespace splat {
+namespace noise {
+
+#if SPLAT_NOISE_AVX512
+
+namespace {
+
+struct Avx512Lanes {
+  using F = __m512;
+  using M = __mmask16;
+  static constexpr size_t kWidth = 16;
+
+  static F load(const float *p) {
+    return _mm512_loadu_ps(p);
+  }
+  static void store(float *p, F v) {
+    _mm512_storeu_ps(p, v);
+  }
+  static F set1(float x) {
+    return _mm512_set1_ps(x);
+  }
+  static F add(F a, F b) {
+    return _mm512_add_ps(a, b);
+  }
+  static F sub(F a, F b) {
+    return _mm512_sub_ps(a, b);
+  }
+  static F mul(F a, F b) {
+    return _mm512_mul_ps(a, b);
+  }
+  static F div(F a, F b) {
+    return _mm512_div_ps(a, b);
+  }
+  static F min(F a, F b) {
+    return _mm512_min_ps(a, b);
+  }
+  static F max(F a, F b) {
+    return _mm512_max_ps(a, b);
+  }
+  static F floor(F a) {
+    return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  }
+  static F sqrt(F a) {
+    return _mm512_sqrt_ps(a);
+  }
+  static M lt(F a, F b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+  }
+  static F select(M m, F a, F b) {
+    return _mm512_mask_blend_ps(m, b, a);
+  }
+};
+
+void simplexPerlin3DDerivAvx512(const float *px, const float *py, const float *pz, float *dx,
+                                float *dy, float *dz, size_t count) {
+  detail::simplexPerlin3DDerivBatch<Avx512Lanes>(px, py, pz, dx, dy, dz, count);
+}
+
+} // anonymous
+
+const KernelFn kAvx512Kernel = &simplexPerlin3DDerivAvx512;
+
+#else
+
+const KernelFn kAvx512Kernel = nullptr;
+
+#endif
+
+} // noise
+} // splat
@@ -0,0 +1,96 @@
+#include "NoiseField.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+static const uint32_t kGroupSizeXYZ = 8;
+
+static uint32_t groupCount(uint32_t size) {
+  return (size + kGroupSizeXYZ - 1) / kGroupSizeXYZ;
+}
+
+
+NoiseField::NoiseField(const ProgramCacheRef &programCache, const AxisAlignedBox &bounds,
+                       const uvec3 &res, uint32_t slicesPerFrame)
+: front(0), bounds(bounds), res(res), slicesPerFrame(slicesPerFrame), bakeSlice(0), baked(false) {
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_XYZ", std::to_string(kGroupSizeXYZ));
+    bakeProg = programCache->createCompute(fmt.compute(app::getAssetPath("noise_bake_cs.glsl")));
+  }
+
+  {
+    auto fmt = gl::Texture3d::Format()
+                   .immutableStorage()
+                   .internalFormat(GL_RGBA16F)
+                   .minFilter(GL_LINEAR)
+                   .magFilter(GL_LINEAR)
+                   .wrap(GL_CLAMP_TO_EDGE);
+    fmt.setMaxMipmapLevel(0);
+
+    for (auto &tex : textures) tex = gl::Texture3d::create(res.x, res.y, res.z, fmt);
+  }
+
+  bakeTimes[0] = bakeTimes[1] = 0.0f;
+  bakeBounds[0] = bakeBounds[1] = bounds;
+}
+
+void NoiseField::bakeSlices(int index, float time, uint32_t sliceBegin, uint32_t sliceEnd) {
+  bakeProg->bind();
+  bakeProg->uniform("boundsMin", bakeBounds[index].getMin());
+  bakeProg->uniform("boundsMax", bakeBounds[index].getMax());
+  bakeProg->uniform("res", res);
+  bakeProg->uniform("sliceOffset", sliceBegin);
+  bakeProg->uniform("sliceEnd", sliceEnd);
+  bakeProg->uniform("bakeTime", time);
+
+  glBindImageTexture(0, textures[index]->getId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+  glDispatchCompute(groupCount(res.x), groupCount(res.y), groupCount(sliceEnd - sliceBegin));
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  bakeTimes[index] = time;
+}
+
+void NoiseField::update(float time) {
+  // The first bake has to be complete before anything samples the front volume.
+  if (!baked) {
+    bakeBounds[front] = bounds;
+    bakeSlices(front, time, 0, res.z);
+    baked = true;
+    return;
+  }
+
+  int back = 1 - front;
+
+  // Every slice of the back volume is baked for the time the pass started.
+  float bakeTime = bakeSlice == 0 ? time : bakeTimes[back];
+  if (bakeSlice == 0) bakeBounds[back] = bounds;
+  uint32_t sliceEnd = std::min(bakeSlice + slicesPerFrame, res.z);
+  bakeSlices(back, bakeTime, bakeSlice, sliceEnd);
+
+  bakeSlice = sliceEnd;
+  if (bakeSlice == res.z) {
+    front = back;
+    bakeSlice = 0;
+  }
+}
+
+void NoiseField::bind(const ComputeProgRef &prog, uint8_t textureUnit) const {
+  const auto &frontBounds = bakeBounds[front];
+  mat4 worldToUnitMtx = glm::translate(glm::scale(vec3(1.0f) / vec3(frontBounds.getSize())),
+                                       -frontBounds.getMin());
+
+  textures[front]->bind(textureUnit);
+  prog->uniform("noiseFieldVolume", true);
+  prog->uniform("noiseFieldTex", int(textureUnit));
+  prog->uniform("worldToNoiseFieldMtx", worldToUnitMtx);
+  prog->uniform("noiseFieldTime", bakeTimes[front]);
+}
+
+void NoiseField::unbind(uint8_t textureUnit) const {
+  textures[front]->unbind(textureUnit);
+}
+
+} // splat
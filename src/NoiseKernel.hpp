@@ -0,0 +1,229 @@
+#pragma once
+
+// NOTE(ryan): Private to the Noise*.cpp translation units. The kernel is written once against a
+// small set of lane operations and instantiated per instruction set, with each instantiation
+// living in its own translation unit compiled for that instruction set. Nothing in here may call
+// out to non-inlined library code, otherwise the linker could pick an AVX-encoded copy of it for
+// the scalar path.
+
+#include <cstddef>
+#include <cstring>
+
+// NOTE(ryan): Every instruction set has to give the same bits, so no mul + add may be fused into
+// an FMA. GCC ignores the STDC pragma and needs its own. The projects also build these files with
+// /fp:precise and no /fp:contract.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+namespace splat {
+namespace noise {
+
+using KernelFn = void (*)(const float *px, const float *py, const float *pz, float *dx, float *dy,
+                          float *dz, size_t count);
+
+// Null when the compiler can't target the instruction set.
+extern const KernelFn kScalarKernel, kSse4Kernel, kAvx2Kernel, kAvx512Kernel;
+
+
+namespace detail {
+
+// Mirrors Simplex3D_GetCornerVectors, FAST32_hash_3D and SimplexPerlin3D_Deriv in noise.glsl. The
+// GLSL vec4s hold the four simplex corners, here each corner is its own lane vector and a lane is
+// one input point. Comments reference the GLSL names.
+template <typename L>
+inline void simplexPerlin3DDeriv(typename L::F Px, typename L::F Py, typename L::F Pz,
+                                 typename L::F &outX, typename L::F &outY, typename L::F &outZ) {
+  using F = typename L::F;
+
+  const F zero = L::set1(0.0f), one = L::set1(1.0f);
+
+  // Simplex3D_GetCornerVectors
+  F vx[4], vy[4], vz[4];
+  F Pix, Piy, Piz;
+  F Pi1x, Pi1y, Pi1z, Pi2x, Pi2y, Pi2z;
+  {
+    const F skew = L::set1(1.0f / 3.0f), unskew = L::set1(1.0f / 6.0f);
+    const F pyramidHeight = L::set1(0.70710678118654752440084436210485f);
+
+    Px = L::mul(Px, pyramidHeight);
+    Py = L::mul(Py, pyramidHeight);
+    Pz = L::mul(Pz, pyramidHeight);
+
+    F s = L::add(L::add(L::mul(Px, skew), L::mul(Py, skew)), L::mul(Pz, skew));
+    Pix = L::floor(L::add(Px, s));
+    Piy = L::floor(L::add(Py, s));
+    Piz = L::floor(L::add(Pz, s));
+
+    F u = L::add(L::add(L::mul(Pix, unskew), L::mul(Piy, unskew)), L::mul(Piz, unskew));
+    F x0x = L::add(L::sub(Px, Pix), u);
+    F x0y = L::add(L::sub(Py, Piy), u);
+    F x0z = L::add(L::sub(Pz, Piz), u);
+
+    // g = step(x0.yzx, x0.xyz), l = 1.0 - g
+    F gx = L::select(L::lt(x0x, x0y), zero, one);
+    F gy = L::select(L::lt(x0y, x0z), zero, one);
+    F gz = L::select(L::lt(x0z, x0x), zero, one);
+    F lx = L::sub(one, gx), ly = L::sub(one, gy), lz = L::sub(one, gz);
+
+    // Pi_1 = min(g.xyz, l.zxy), Pi_2 = max(g.xyz, l.zxy)
+    Pi1x = L::min(gx, lz);
+    Pi1y = L::min(gy, lx);
+    Pi1z = L::min(gz, ly);
+    Pi2x = L::max(gx, lz);
+    Pi2y = L::max(gy, lx);
+    Pi2z = L::max(gz, ly);
+
+    const F cornerPos = L::set1(0.5f);
+    vx[0] = x0x;
+    vy[0] = x0y;
+    vz[0] = x0z;
+    vx[1] = L::add(L::sub(x0x, Pi1x), unskew);
+    vy[1] = L::add(L::sub(x0y, Pi1y), unskew);
+    vz[1] = L::add(L::sub(x0z, Pi1z), unskew);
+    vx[2] = L::add(L::sub(x0x, Pi2x), skew);
+    vy[2] = L::add(L::sub(x0y, Pi2y), skew);
+    vz[2] = L::add(L::sub(x0z, Pi2z), skew);
+    vx[3] = L::sub(x0x, cornerPos);
+    vy[3] = L::sub(x0y, cornerPos);
+    vz[3] = L::sub(x0z, cornerPos);
+  }
+
+  // FAST32_hash_3D
+  F hash[3][4];
+  {
+    const F domain = L::set1(69.0f), oneOverDomain = L::set1(1.0f / 69.0f);
+    const F domainMax = L::set1(69.0f - 1.5f);
+    const F offsetX = L::set1(50.0f), offsetY = L::set1(161.0f);
+    const float largeFloats[3] = {635.298681f, 682.357502f, 668.926525f};
+    const float zInc[3] = {48.500388f, 65.294118f, 63.934599f};
+
+    // Truncate the domain.
+    F gx = L::sub(Pix, L::mul(L::floor(L::mul(Pix, oneOverDomain)), domain));
+    F gy = L::sub(Piy, L::mul(L::floor(L::mul(Piy, oneOverDomain)), domain));
+    F gz = L::sub(Piz, L::mul(L::floor(L::mul(Piz, oneOverDomain)), domain));
+
+    // gridcell_inc1 = step(gridcell, vec3(DOMAIN - 1.5)) * (gridcell + 1.0)
+    F gx1 = L::mul(L::select(L::lt(domainMax, gx), zero, one), L::add(gx, one));
+    F gy1 = L::mul(L::select(L::lt(domainMax, gy), zero, one), L::add(gy, one));
+    F gz1 = L::mul(L::select(L::lt(domainMax, gz), zero, one), L::add(gz, one));
+
+    // Compute x*x*y*y for the 4 corners. The GLSL mix() with 0/1 weights is a select.
+    F P0x = L::add(gx, offsetX), P0y = L::add(gy, offsetY);
+    F P1x = L::add(gx1, offsetX), P1y = L::add(gy1, offsetY);
+    P0x = L::mul(P0x, P0x);
+    P0y = L::mul(P0y, P0y);
+    P1x = L::mul(P1x, P1x);
+    P1y = L::mul(P1y, P1y);
+
+    const F half = L::set1(0.5f);
+    F v1x = L::select(L::lt(Pi1x, half), P0x, P1x), v1y = L::select(L::lt(Pi1y, half), P0y, P1y);
+    F v2x = L::select(L::lt(Pi2x, half), P0x, P1x), v2y = L::select(L::lt(Pi2y, half), P0y, P1y);
+
+    F P[4] = {L::mul(P0x, P0y), L::mul(v1x, v1y), L::mul(v2x, v2y), L::mul(P1x, P1y)};
+
+    // Get the lowz and highz mods, then apply the v1 and v2 masks.
+    auto v1Low = L::lt(Pi1z, half), v2Low = L::lt(Pi2z, half);
+    for (int k = 0; k < 3; ++k) {
+      F slf = L::set1(largeFloats[k]), zinc = L::set1(zInc[k]);
+      F lowzMod = L::div(one, L::add(slf, L::mul(gz, zinc)));
+      F highzMod = L::div(one, L::add(slf, L::mul(gz1, zinc)));
+
+      F mods[4] = {lowzMod, L::select(v1Low, lowzMod, highzMod),
+                   L::select(v2Low, lowzMod, highzMod), highzMod};
+      for (int c = 0; c < 4; ++c) {
+        F h = L::mul(P[c], mods[c]);
+        hash[k][c] = L::sub(h, L::floor(h));
+      }
+    }
+  }
+
+  // SimplexPerlin3D_Deriv
+  {
+    const F hashBias = L::set1(0.49999f);
+    const F surfletRadius = L::set1(0.5f), minusSix = L::set1(-6.0f);
+    const F finalNormalization = L::set1(37.837227241611314102871574478976f);
+
+    // dot(temp, v1234_x) + dot(m3, hash_0) and friends, summed corner by corner like dot().
+    F tx = zero, ty = zero, tz = zero, mx = zero, my = zero, mz = zero;
+    for (int c = 0; c < 4; ++c) {
+      F h0 = L::sub(hash[0][c], hashBias);
+      F h1 = L::sub(hash[1][c], hashBias);
+      F h2 = L::sub(hash[2][c], hashBias);
+
+      // Normalize random gradient vectors.
+      F norm = L::add(L::add(L::mul(h0, h0), L::mul(h1, h1)), L::mul(h2, h2));
+      norm = L::div(one, L::sqrt(norm));
+      h0 = L::mul(h0, norm);
+      h1 = L::mul(h1, norm);
+      h2 = L::mul(h2, norm);
+
+      // Evaluate gradients.
+      F grad = L::add(L::add(L::mul(h0, vx[c]), L::mul(h1, vy[c])), L::mul(h2, vz[c]));
+
+      // Evaluate the surflet f(x)=(0.5-x*x)^3
+      F m = L::add(L::add(L::mul(vx[c], vx[c]), L::mul(vy[c], vy[c])), L::mul(vz[c], vz[c]));
+      m = L::max(L::sub(surfletRadius, m), zero);
+      F m2 = L::mul(m, m);
+      F m3 = L::mul(m, m2);
+
+      // Calc the deriv.
+      F temp = L::mul(L::mul(minusSix, m2), grad);
+      tx = L::add(tx, L::mul(temp, vx[c]));
+      ty = L::add(ty, L::mul(temp, vy[c]));
+      tz = L::add(tz, L::mul(temp, vz[c]));
+      mx = L::add(mx, L::mul(m3, h0));
+      my = L::add(my, L::mul(m3, h1));
+      mz = L::add(mz, L::mul(m3, h2));
+    }
+
+    outX = L::mul(L::add(tx, mx), finalNormalization);
+    outY = L::mul(L::add(ty, my), finalNormalization);
+    outZ = L::mul(L::add(tz, mz), finalNormalization);
+  }
+}
+
+// Runs the kernel over whole lane vectors, then pads the remainder out to a full vector on the
+// stack so the tail doesn't need a separate code path.
+template <typename L>
+inline void simplexPerlin3DDerivBatch(const float *px, const float *py, const float *pz, float *dx,
+                                      float *dy, float *dz, size_t count) {
+  using F = typename L::F;
+  const size_t W = L::kWidth;
+
+  size_t i = 0;
+  for (; i + W <= count; i += W) {
+    F x, y, z;
+    simplexPerlin3DDeriv<L>(L::load(px + i), L::load(py + i), L::load(pz + i), x, y, z);
+    L::store(dx + i, x);
+    L::store(dy + i, y);
+    L::store(dz + i, z);
+  }
+
+  if (i < count) {
+    const size_t n = count - i;
+    float tx[L::kWidth] = {}, ty[L::kWidth] = {}, tz[L::kWidth] = {};
+    std::memcpy(tx, px + i, n * sizeof(float));
+    std::memcpy(ty, py + i, n * sizeof(float));
+    std::memcpy(tz, pz + i, n * sizeof(float));
+
+    F x, y, z;
+    simplexPerlin3DDeriv<L>(L::load(tx), L::load(ty), L::load(tz), x, y, z);
+    L::store(tx, x);
+    L::store(ty, y);
+    L::store(tz, z);
+
+    std::memcpy(dx + i, tx, n * sizeof(float));
+    std::memcpy(dy + i, ty, n * sizeof(float));
+    std::memcpy(dz + i, tz, n * sizeof(float));
+  }
+}
+
+} // detail
+
+} // noise
+} // splat
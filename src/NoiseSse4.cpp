@@ -0,0 +1,66 @@
+#include "NoiseKernel.hpp"
+
+#include <smmintrin.h>
+
+namespace splat {
+namespace noise {
+
+namespace {
+
+struct Sse4Lanes {
+  using F = __m128;
+  using M = __m128;
+  static constexpr size_t kWidth = 4;
+
+  static F load(const float *p) {
+    return _mm_loadu_ps(p);
+  }
+  static void store(float *p, F v) {
+    _mm_storeu_ps(p, v);
+  }
+  static F set1(float x) {
+    return _mm_set1_ps(x);
+  }
+  static F add(F a, F b) {
+    return _mm_add_ps(a, b);
+  }
+  static F sub(F a, F b) {
+    return _mm_sub_ps(a, b);
+  }
+  static F mul(F a, F b) {
+    return _mm_mul_ps(a, b);
+  }
+  static F div(F a, F b) {
+    return _mm_div_ps(a, b);
+  }
+  static F min(F a, F b) {
+    return _mm_min_ps(a, b);
+  }
+  static F max(F a, F b) {
+    return _mm_max_ps(a, b);
+  }
+  static F floor(F a) {
+    return _mm_floor_ps(a);
+  }
+  static F sqrt(F a) {
+    return _mm_sqrt_ps(a);
+  }
+  static M lt(F a, F b) {
+    return _mm_cmplt_ps(a, b);
+  }
+  static F select(M m, F a, F b) {
+    return _mm_blendv_ps(b, a, m);
+  }
+};
+
+void simplexPerlin3DDerivSse4(const float *px, const float *py, const float *pz, float *dx,
+                              float *dy, float *dz, size_t count) {
+  detail::simplexPerlin3DDerivBatch<Sse4Lanes>(px, py, pz, dx, dy, dz, count);
+}
+
+} // anonymous
+
+const KernelFn kSse4Kernel = &simplexPerlin3DDerivSse4;
+
+} // noise
+} // splat
@@ -0,0 +1,119 @@
+#include "OverdrawHeatmap.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+static const uint32_t kStatsGroupSizeXY = 16;
+
+
+OverdrawHeatmap::OverdrawHeatmap(const ProgramCacheRef &programCache) : statsSlot(0) {
+  statsProg = programCache->createCompute(
+      ComputeProg::Format()
+          .compute(app::getAssetPath("overdraw_stats_cs.glsl"))
+          .define("BIN_COUNT", std::to_string(kBinCount) + "u"));
+
+  auto fmt = gl::GlslProg::Format()
+                 .vertex(app::loadAsset("fullscreen_vs.glsl"))
+                 .fragment(app::loadAsset("overdraw_heatmap_fs.glsl"));
+  heatmapProg = gl::GlslProg::create(fmt);
+  emptyVao = gl::Vao::create();
+
+  for (uint32_t i = 0; i < kReadbackCount; ++i) {
+    statsBuffers[i] = gl::Ssbo::create(sizeof(Stats), nullptr, GL_DYNAMIC_READ);
+    statsFences[i] = nullptr;
+  }
+}
+
+OverdrawHeatmap::~OverdrawHeatmap() {
+  for (auto fence : statsFences) {
+    if (fence) glDeleteSync(fence);
+  }
+}
+
+void OverdrawHeatmap::readStats() {
+  auto &fence = statsFences[statsSlot];
+  if (!fence) return;
+
+  if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+  glDeleteSync(fence);
+  fence = nullptr;
+
+  auto stats = std::unique_ptr<Stats>(new Stats);
+  statsBuffers[statsSlot]->bind();
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Stats), stats.get());
+  statsBuffers[statsSlot]->unbind();
+
+  uint64_t pixelCount = 0;
+  for (uint32_t i = 0; i < kBinCount; ++i) {
+    pixelCount += stats->histogram[i];
+  }
+
+  totalFragments = (uint64_t(stats->totalHi) << 32) | stats->totalLo;
+  averageDepthComplexity = pixelCount ? float(double(totalFragments) / pixelCount) : 0.0f;
+
+  uint64_t below = 0;
+  percentile99 = maxCount = 0;
+  for (uint32_t i = 0; i < kBinCount; ++i) {
+    if (stats->histogram[i] == 0) continue;
+    if (below < pixelCount * 99 / 100) percentile99 = i;
+    below += stats->histogram[i];
+    maxCount = i;
+  }
+}
+
+void OverdrawHeatmap::begin(const ivec2 &size) {
+  if (!countTexture || countTexture->getSize() != size) {
+    auto fmt = gl::Texture2d::Format()
+                   .immutableStorage()
+                   .internalFormat(GL_R32UI)
+                   .minFilter(GL_NEAREST)
+                   .magFilter(GL_NEAREST);
+    countTexture = gl::Texture2d::create(size.x, size.y, fmt);
+  }
+
+  glClearTexImage(countTexture->getId(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+  glBindImageTexture(0, countTexture->getId(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+}
+
+void OverdrawHeatmap::end() {
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+  // NOTE(ryan): Reduce the counts, skipped if the readback slot is still in flight.
+  readStats();
+  if (!statsFences[statsSlot]) {
+    auto &statsBuffer = statsBuffers[statsSlot];
+    statsBuffer->bind();
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                      nullptr);
+    statsBuffer->unbind();
+
+    statsProg->bind();
+    statsBuffer->bindBase(0);
+    glDispatchCompute((countTexture->getWidth() + kStatsGroupSizeXY - 1) / kStatsGroupSizeXY,
+                      (countTexture->getHeight() + kStatsGroupSizeXY - 1) / kStatsGroupSizeXY, 1);
+    // The fence only says the dispatch is done, the readback needs the writes made visible.
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    statsBuffer->unbindBase();
+
+    statsFences[statsSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    statsSlot = (statsSlot + 1) % kReadbackCount;
+  }
+
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+}
+
+void OverdrawHeatmap::draw() {
+  gl::ScopedGlslProg scopedProg(heatmapProg);
+  gl::ScopedTextureBind scopedCounts(countTexture, 0);
+  gl::ScopedBlend scopedBlend(false);
+  gl::ScopedDepth scopedDepth(false);
+  gl::ScopedVao scopedVao(emptyVao);
+
+  heatmapProg->uniform("overdrawTex", 0);
+  heatmapProg->uniform("heatmapMax", heatmapMax);
+  gl::drawArrays(GL_TRIANGLES, 0, 3);
+}
+
+} // splat
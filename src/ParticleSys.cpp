@@ -6,7 +6,7 @@
 #include "cinder/app/App.h"
 #include "glm/gtx/extented_min_max.hpp"
 
-#include <numeric>
+#include <limits>
 
 namespace splat {
 
@@ -17,13 +17,66 @@ static constexpr uint32_t sqr(uint32_t x) {
 static const uint32_t kMaxParticles = sqr(2 << 9);
 static const uint32_t kWorkGroupSizeX = 128;
 static const uint32_t kVolumeGroupSizeXYZ = 8;
+static const uint32_t kNoiseFieldRes = 128;
+static const uint32_t kNoiseFieldSlicesPerFrame = 8;
+static const uint8_t kDensityCascadesUnit = 5;
+static const uint8_t kForceFieldsUnit = kDensityCascadesUnit + 2 * DensityCascades::kMaxCascades;
+// The update shader's forces and damping were tuned at this tick rate, see tickScale in update_cs.
+static const float kReferenceTickRate = 60.0f;
+// Longest tick simulated in one go, so a hitch can't fling particles or flood the emitters.
+static const float kMaxTimeDelta = 4.0f / kReferenceTickRate;
+static const AxisAlignedBox kInitVolumeBounds(vec3(-2.0f), vec3(2.0f));
+
+// Zero scale particles are dead until emitted.
+static void clearParticles(const gl::SsboRef &buffer) {
+  buffer->bind();
+  glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+  buffer->unbind();
+}
 
 
-ParticleSys::ParticleSys() : shaderInit(true) {
-  volumeBounds.set(vec3(-2.0f), vec3(2.0f));
+ParticleSys::ParticleSys(const ProgramCacheRef &programCache, const UploadRingRef &uploadRing)
+: programCache(programCache), uploadRing(uploadRing) {
+  volumeBounds = kInitVolumeBounds;
   volumeRes = uvec3(64);
 
-  radixSort = std::make_shared<RadixSort>(kMaxParticles, 128);
+  frameConstants = std::make_shared<FrameConstants>(uploadRing);
+  radixSort = std::make_shared<RadixSort>(programCache, kMaxParticles, 128);
+
+  {
+    emitters = std::make_shared<ParticleEmitters>(programCache, uploadRing, kMaxParticles,
+                                                  kWorkGroupSizeX);
+
+    // NOTE(ryan): Stand-ins for the old fixed population, a shell plus 2.5% flotsam, both
+    // recycled every 2000 frames. The rates keep the pool about full, and the prewarm fills it on
+    // the first tick rather than over a whole lifetime. The shell is tinted by the density
+    // gradient, the flotsam drifts freely outside the volume.
+    const float lifetime = 2000.0f / 60.0f;
+
+    Emitter shell = {};
+    shell.radiusMin = 0.5f;
+    shell.radiusMax = 0.8f;
+    shell.scaleMin = 1.0f;
+    shell.scaleMax = 4.0f;
+    shell.color = vec4(0.25f, 0.0625f, 0.25f, 0.25f);
+    shell.flags = Emitter::kDensityTint;
+    shell.lifetime = lifetime;
+    shell.rate = 0.975f * kMaxParticles / lifetime;
+    emitters->emitters.push_back(shell);
+
+    Emitter flotsam = {};
+    flotsam.radiusMax = 4.0f;
+    flotsam.scaleMin = 1.0f;
+    flotsam.scaleMax = 2.0f;
+    flotsam.color = vec4(0.1f);
+    flotsam.flags = Emitter::kUnbounded;
+    flotsam.lifetime = lifetime;
+    flotsam.rate = 0.025f * kMaxParticles / lifetime;
+    emitters->emitters.push_back(flotsam);
+    emitters->prewarm();
+  }
+
+  forceFields = std::make_shared<ForceFields>(programCache, uploadRing, kWorkGroupSizeX);
 
   {
     auto fmt = gl::Texture::Format().mipmap();
@@ -33,33 +86,31 @@ ParticleSys::ParticleSys() : shaderInit(true) {
   {
     auto fmt = gl::GlslProg::Format()
                    .vertex(app::loadAsset("render_vs.glsl"))
-                   .fragment(app::loadAsset("render_fs.glsl"))
-                   .attribLocation("particleId", 0);
+                   .fragment(app::loadAsset("render_fs.glsl"));
     particleRenderProg = gl::GlslProg::create(fmt);
-  }
 
-  {
-    std::vector<GLuint> ids(kMaxParticles);
-    std::iota(ids.begin(), ids.end(), 0);
-    particleIds = gl::Vbo::create(GL_ARRAY_BUFFER, ids, GL_STATIC_DRAW);
+    fmt.fragment(app::loadAsset("overdraw_fs.glsl"));
+    particleOverdrawProg = gl::GlslProg::create(fmt);
+
+    fmt.vertex(app::loadAsset("render_billboard_vs.glsl"));
+    billboardOverdrawProg = gl::GlslProg::create(fmt);
 
-    particleAttrs = gl::Vao::create();
-    gl::ScopedVao scopedVao(particleAttrs);
-    gl::ScopedBuffer scopedIds(particleIds);
-    gl::enableVertexAttribArray(0);
-    gl::vertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    fmt.fragment(app::loadAsset("render_billboard_fs.glsl"));
+    billboardRenderProg = gl::GlslProg::create(fmt);
   }
 
-  {
-    auto initParticles = std::unique_ptr<Particle[]>(new Particle[kMaxParticles]);
-    for (size_t i = 0; i < kMaxParticles; ++i) {
-      initParticles[i] = {vec3(0.0f), 1.0f, vec4(0.0f)}; // Rand::randVec3(), 1.0f, vec4(1.0)
-    }
+  // NOTE(ryan): The render shaders pull everything from the particle buffer by vertex or instance
+  // index, but core profile still wants a VAO bound to draw.
+  emptyVao = gl::Vao::create();
+  glGetFloatv(GL_POINT_SIZE_RANGE, &pointSizeRange[0]);
 
+  {
+    // NOTE(ryan): Cleared on the GPU rather than uploaded from a zeroed array on the heap.
     auto bufferSize = kMaxParticles * sizeof(Particle);
-    particles = gl::Ssbo::create(bufferSize, initParticles.get(), GL_STATIC_DRAW);
-    particlesPrev = gl::Ssbo::create(bufferSize, initParticles.get(), GL_STATIC_DRAW);
+    particles = gl::Ssbo::create(bufferSize, nullptr, GL_STATIC_DRAW);
+    particlesPrev = gl::Ssbo::create(bufferSize, nullptr, GL_STATIC_DRAW);
     particlesSorted = gl::Ssbo::create(bufferSize, nullptr, GL_STATIC_DRAW);
+    for (auto &buffer : {particles, particlesPrev}) clearParticles(buffer);
   }
 
   {
@@ -79,87 +130,184 @@ ParticleSys::ParticleSys() : shaderInit(true) {
   }
 
   {
-    auto fmt = gl::GlslProg::Format().preprocess(true).define("WORK_GROUP_SIZE_X",
-                                                              std::to_string(kWorkGroupSizeX));
-    densityAccumProg = gl::GlslProg::create(fmt.compute(app::loadAsset("density_accum_cs.glsl")));
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(kWorkGroupSizeX));
+    densityAccumProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("density_accum_cs.glsl")));
+    FrameConstants::verifyLayout(*densityAccumProg, "density_accum_cs.glsl");
   }
 
   {
-    auto fmt = gl::GlslProg::Format().preprocess(true).define("WORK_GROUP_SIZE_XYZ",
-                                                              std::to_string(kVolumeGroupSizeXYZ));
-    densityGradProg = gl::GlslProg::create(fmt.compute(app::loadAsset("density_grad_cs.glsl")));
+    auto fmt =
+        ComputeProg::Format().define("WORK_GROUP_SIZE_XYZ", std::to_string(kVolumeGroupSizeXYZ));
+    densityGradProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("density_grad_cs.glsl")));
+    FrameConstants::verifyLayout(*densityGradProg, "density_grad_cs.glsl");
   }
+
+  particleInterpolateProg = programCache->createCompute(
+      ComputeProg::Format()
+          .compute(app::getAssetPath("interpolate_cs.glsl"))
+          .define("WORK_GROUP_SIZE_X", std::to_string(kWorkGroupSizeX))
+          .define("PARTICLE_COUNT", std::to_string(kMaxParticles) + "u"));
 }
 
 
 void ParticleSys::update(float time, uint32_t frameId, const vec3 &eyePos, const vec3 &eyeVel,
                          const vec3 &viewDir) {
-  mat4 worldToVolumeMtx = glm::translate(glm::scale(vec3(volumeRes) / vec3(volumeBounds.getSize())),
-                                         -volumeBounds.getMin());
-  mat4 worldToUnitVolumeMtx =
-      glm::translate(glm::scale(vec3(1.0f) / vec3(volumeBounds.getSize())), -volumeBounds.getMin());
+  // The first tick after a reset has no previous time to step from, it only emits.
+  float timeDelta = timePrevValid ? glm::clamp(time - timePrev, 0.0f, kMaxTimeDelta) : 0.0f;
+  timePrev = time;
+  timePrevValid = true;
+
+  if (boundsFitter && boundsFitter->readBounds()) {
+    volumeBounds = boundsFitter->bounds;
+    if (noiseField) noiseField->setBounds(volumeBounds);
+  }
 
-  if (particleUpdateProg) {
-    particleUpdateProg->bind();
-    particleUpdateProg->uniform("time", time);
-    particleUpdateProg->uniform("frameId", frameId);
-    particleUpdateProg->uniform("eyePos", eyePos);
-    particleUpdateProg->uniform("eyeVel", eyeVel);
-    particleUpdateProg->uniform("viewDir", viewDir);
+  {
+    FrameConstants::Data data = {};
+    data.worldToVolumeMtx = glm::translate(
+        glm::scale(vec3(volumeRes) / vec3(volumeBounds.getSize())), -volumeBounds.getMin());
+    data.worldToUnitVolumeMtx = glm::translate(
+        glm::scale(vec3(1.0f) / vec3(volumeBounds.getSize())), -volumeBounds.getMin());
+    data.eyePos = eyePos;
+    data.time = time;
+    data.eyeVel = eyeVel;
+    data.frameId = frameId;
+    data.viewDir = viewDir;
+    data.compile = shaderCompile;
+    data.volumeBoundsMin = volumeBounds.getMin();
+    data.volumeBoundsMax = volumeBounds.getMax();
+    data.volumeRes = volumeRes;
+    data.sortAxis = -viewDir;
+    data.timeDelta = timeDelta;
+    updateFrameConstants(data);
+    frameData = data;
+  }
+
+  // NOTE(ryan): Played back trajectories don't run the update shader, so the passes that only
+  // feed it (noise field, density gradients and cascades) are skipped. The density itself is
+  // still drawn by the volume renderer.
+  const bool playback = bool(trajectoryPlayer);
+
+  if (noiseFieldEnabled && !playback) {
+    if (!noiseField) {
+      noiseField = std::make_shared<NoiseField>(programCache, volumeBounds, uvec3(kNoiseFieldRes),
+                                                kNoiseFieldSlicesPerFrame);
+    }
+    noiseField->update(time);
+  }
+
+  // NOTE(ryan): A cache being played back stands in for the whole simulation step. Otherwise
+  // nothing is emitted until there's an update shader to take the new particles.
+  if (pointCloudImport) {
+    if (pointCloudImport->step(particles)) finishImport();
+  } else if (trajectoryPlayer) {
+    trajectoryPlayer->apply(particles, particlesPrev, *emitters);
+  } else if (particleUpdateProg) {
+    emitters->emit(timeDelta, particles, particlesPrev);
+
+    if (neighbourGridEnabled) {
+      if (!neighbourGrid) {
+        neighbourGrid = std::make_shared<NeighbourGrid>(programCache, radixSort, kMaxParticles,
+                                                        kWorkGroupSizeX);
+      }
+      neighbourGrid->build(volumeBounds, neighbourGridCellSize, particles, *emitters);
+    }
 
-    particleUpdateProg->uniform("init", shaderInit);
-    particleUpdateProg->uniform("compile", shaderCompile);
+    if (fluidEnabled) {
+      if (!fluidSolver) {
+        fluidSolver = std::make_shared<FluidSolver>(programCache, volumeRes, kWorkGroupSizeX);
+      }
+      fluidSolver->solve(particles, particlesPrev, *emitters);
+    }
 
-    particleUpdateProg->uniform("volumeBoundsMin", volumeBounds.getMin());
-    particleUpdateProg->uniform("volumeBoundsMax", volumeBounds.getMax());
-    particleUpdateProg->uniform("volumeRes", volumeRes);
-    particleUpdateProg->uniform("worldToUnitVolumeMtx", worldToUnitVolumeMtx);
+    forceFields->update();
 
+    particleUpdateProg->bind();
+    // Kept off zero, update_cs divides by it.
+    particleUpdateProg->uniform("tickScale", glm::max(timeDelta * kReferenceTickRate, 0.01f));
     particleUpdateProg->uniform("densityGradTex", 0);
     particleUpdateProg->uniform("densityTex", 1);
     gl::ScopedTextureBind scopedDensityGradTex(densityGradTexture, 0);
     gl::ScopedTextureBind scopedDensityTex(densityTexture, 1);
 
+    if (noiseFieldEnabled) {
+      noiseField->bind(particleUpdateProg, 2);
+    } else {
+      particleUpdateProg->uniform("noiseFieldVolume", false);
+    }
+
+    if (neighbourGridEnabled) {
+      neighbourGrid->bind(particleUpdateProg);
+    } else {
+      particleUpdateProg->uniform("gridEnabled", false);
+    }
+
+    if (fluidEnabled) {
+      fluidSolver->bind(particleUpdateProg, 3, 4);
+    } else {
+      particleUpdateProg->uniform("fluidEnabled", false);
+    }
+
+    bool cascadesBound = cascadesEnabled && densityCascades;
+    if (cascadesBound) {
+      densityCascades->bind(particleUpdateProg, kDensityCascadesUnit);
+    } else {
+      DensityCascades::bindDisabled(particleUpdateProg, kDensityCascadesUnit);
+    }
+
+    forceFields->bind(particleUpdateProg, kForceFieldsUnit);
+
     particles->bindBase(0);
     particlesPrev->bindBase(1);
+    emitters->bindBuffers();
+    emitters->bindEmitters();
 
-    glDispatchCompute(kMaxParticles / kWorkGroupSizeX, 1, 1);
+    emitters->dispatchAlive();
     glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
+    emitters->unbindEmitters();
+    emitters->unbindBuffers();
     particlesPrev->unbindBase();
     particles->unbindBase();
 
-    shaderInit = false;
+    if (noiseFieldEnabled) noiseField->unbind(2);
+    if (neighbourGridEnabled) neighbourGrid->unbind();
+    if (fluidEnabled) fluidSolver->unbind(3, 4);
+    if (cascadesBound) densityCascades->unbind(kDensityCascadesUnit);
+    forceFields->unbind(kForceFieldsUnit);
+
+    emitters->finish();
+
     shaderCompile = false;
+
+    if (trajectoryBaker) trajectoryBaker->capture(particles);
   }
 
+  // The update reads whatever density is current, so it can lag a few ticks to save the passes.
+  bool updateDensity = densityInterval <= 1 || frameId % uint32_t(densityInterval) == 0;
+
   // NOTE(ryan): Accumulate particles into the density texture.
-  {
+  if (updateDensity) {
     glClearTexImage(densityTexture->getId(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
 
     densityAccumProg->bind();
-    densityAccumProg->uniform("volumeRes", volumeRes);
-    densityAccumProg->uniform("worldToVolumeMtx", worldToVolumeMtx);
-    // densityAccumProg->uniform("boundsMin", volumeBounds.getMin());
-    // densityAccumProg->uniform("oneOverBoundsSize", vec3(1.0f) / volumeBounds.getSize());
-
-    vec3 celSize = vec3(volumeBounds.getSize()) / vec3(volumeRes);
-    float celScale = glm::min(celSize.x, celSize.y, celSize.z);
-    densityAccumProg->uniform("oneOverCelScale", 1.0f / celScale);
 
     particles->bindBase(0);
+    emitters->bindBuffers();
     glBindImageTexture(1, densityTexture->getId(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
 
-    glDispatchCompute(kMaxParticles / kWorkGroupSizeX, 1, 1);
+    emitters->dispatchAlive();
     glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
 
+    emitters->unbindBuffers();
     particles->unbindBase();
   }
 
   // NOTE(ryan): Compute density gradients.
-  {
+  if (updateDensity && !playback) {
     densityGradProg->bind();
-    densityGradProg->uniform("volumeRes", volumeRes);
 
     glBindImageTexture(0, densityTexture->getId(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
     glBindImageTexture(1, densityGradTexture->getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
@@ -169,34 +317,268 @@ void ParticleSys::update(float time, uint32_t frameId, const vec3 &eyePos, const
     glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
   }
 
-  radixSort->sort(particles->getId(), particlesSorted->getId(), -viewDir, -2.0f, 2.0f);
+  // finishImport and reset drop the fitter, prepareDraw makes a new one around the new bounds.
+  if (dynamicBoundsEnabled && boundsFitter) boundsFitter->fit(particles, *emitters);
+
+  if (cascadesEnabled && updateDensity && !playback) {
+    if (!densityCascades) {
+      float baseCellSize = volumeBounds.getSize().x / volumeRes.x;
+      densityCascades = std::make_shared<DensityCascades>(programCache, int(volumeRes.x),
+                                                          baseCellSize, kWorkGroupSizeX);
+    }
+    densityCascades->build(cascadeCount, eyePos, particles, *emitters);
+  }
 }
 
-void ParticleSys::draw(float pointSize) {
+void ParticleSys::prepareDraw(float alpha, const vec3 &eyePos, const vec3 &viewDir) {
+  {
+    FrameConstants::Data data = frameData;
+    data.eyePos = eyePos;
+    data.viewDir = viewDir;
+    data.sortAxis = -viewDir;
+    data.compile = false;
+    updateFrameConstants(data);
+  }
+
+  if (lodEnabled) {
+    if (!volumeRenderer) {
+      volumeRenderer = std::make_shared<VolumeRenderer>(programCache, volumeRes, 8, 4);
+    }
+    volumeRenderer->updateBricks(densityTexture);
+  }
+
+  if (alpha >= 1.0f) {
+    radixSort->sort(particles->getId(), particlesSorted->getId());
+    return;
+  }
+
+  // NOTE(ryan): Interpolate into the sorted buffer and sort it in place. The sort should order
+  // what's drawn, and the sorted copy has lost the indices render_vs would need to do it there.
+  particleInterpolateProg->bind();
+  particleInterpolateProg->uniform("alpha", alpha);
+
+  particles->bindBase(0);
+  particlesPrev->bindBase(1);
+  particlesSorted->bindBase(2);
+
+  glDispatchCompute((kMaxParticles + kWorkGroupSizeX - 1) / kWorkGroupSizeX, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  particlesSorted->unbindBase();
+  particlesPrev->unbindBase();
+  particles->unbindBase();
+
+  radixSort->sort(particlesSorted->getId(), particlesSorted->getId());
+}
+
+void ParticleSys::updateFrameConstants(FrameConstants::Data &data) {
+  data.sortZMin = -2.0f;
+  data.sortZMax = 2.0f;
+
+  // The sort range has to cover wherever the bounds have moved to.
+  if (dynamicBoundsEnabled) {
+    float centre = glm::dot(volumeBounds.getCenter(), data.sortAxis);
+    float radius = 0.5f * glm::length(volumeBounds.getSize());
+    data.sortZMin = centre - radius;
+    data.sortZMax = centre + radius;
+  }
+
+  frameConstants->update(data);
+
+  if (dynamicBoundsEnabled) {
+    if (!boundsFitter) {
+      boundsFitter = std::make_shared<VolumeBoundsFitter>(programCache, volumeBounds, volumeRes,
+                                                          kWorkGroupSizeX);
+    }
+    boundsFitter->apply(*frameConstants);
+  }
+}
+
+void ParticleSys::draw(float pointSize, const gl::Texture2dRef &sceneDepth) {
+  pointSize *= pointSizeScale;
+
+  if (particleDownsample <= 1 || !sceneDepth) {
+    drawParticles(pointSize);
+    return;
+  }
+
+  if (!particleTarget) particleTarget = std::make_shared<ParticleTarget>();
+  particleTarget->setSize(sceneDepth->getSize(), particleDownsample);
+
+  {
+    gl::ScopedFramebuffer scopedFbo(particleTarget->fbo);
+    gl::ScopedViewport scopedViewport(particleTarget->fbo->getSize());
+
+    particleTarget->prepare(sceneDepth);
+    // Point sizes are in pixels.
+    drawParticles(pointSize / particleDownsample);
+  }
+
+  particleTarget->composite(sceneDepth);
+}
+
+void ParticleSys::drawParticles(float pointSize) {
+  if (lodEnabled && volumeRenderer) {
+    volumeRenderer->draw(densityTexture, lodDistance);
+  }
+
+  if (computeRasterEnabled) {
+    if (!splatRasterizer) {
+      splatRasterizer = std::make_shared<SplatRasterizer>(programCache, radixSort, kMaxParticles,
+                                                          kWorkGroupSizeX);
+    }
+    float cullDistance =
+        lodEnabled && volumeRenderer ? lodDistance : std::numeric_limits<float>::max();
+    splatRasterizer->draw(particlesSorted, *emitters, particleTexture, pointSize, cullDistance);
+    return;
+  }
+
+  auto prog = billboardsEnabled ? billboardRenderProg : particleRenderProg;
   gl::ScopedTextureBind scopedTex(particleTexture);
-  gl::ScopedGlslProg scopedProg(particleRenderProg);
-  gl::ScopedVao scopedVao(particleAttrs);
+  prog->uniform("texture", 0);
+  drawSplats(prog, pointSize);
+}
 
-  gl::context()->setDefaultShaderVars();
+void ParticleSys::drawSplats(const gl::GlslProgRef &prog, float pointSize) {
+  gl::ScopedGlslProg scopedProg(prog);
+  gl::ScopedVao scopedVao(emptyVao);
 
-  particleRenderProg->uniform("texture", 0);
-  particleRenderProg->uniform("pointSize", pointSize);
+  prog->uniform("pointSize", pointSize);
+  prog->uniform("minPointSize", minPointSize);
+  prog->uniform("lodEnabled", lodEnabled && volumeRenderer != nullptr);
+  prog->uniform("lodDistance", lodDistance);
 
   particlesSorted->bindBase(0);
-  gl::drawArrays(GL_POINTS, 0, kMaxParticles);
+  if (billboardsEnabled) {
+    prog->uniform("maxPointSize", maxPointSize);
+    prog->uniform("viewportSize", vec2(gl::getViewport().second));
+    emitters->drawAliveQuads();
+  } else {
+    prog->uniform("maxPointSize", glm::min(maxPointSize, pointSizeRange.y));
+    emitters->drawAlive(GL_POINTS);
+  }
   particlesSorted->unbindBase();
 }
 
+void ParticleSys::drawOverdraw(float pointSize) {
+  if (!overdrawHeatmap) overdrawHeatmap = std::make_shared<OverdrawHeatmap>(programCache);
+  pointSize *= pointSizeScale;
+
+  overdrawHeatmap->begin(gl::getViewport().second);
+  {
+    gl::ScopedDepth scopedDepth(false);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    drawSplats(billboardsEnabled ? billboardOverdrawProg : particleOverdrawProg, pointSize);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  }
+  overdrawHeatmap->end();
+
+  overdrawHeatmap->draw();
+}
+
+void ParticleSys::reset() {
+  for (auto &buffer : {particles, particlesPrev, particlesSorted}) clearParticles(buffer);
+  emitters->reset();
+  emitters->prewarm();
+
+  glClearTexImage(densityTexture->getId(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+  glClearTexImage(densityGradTexture->getId(), 0, GL_RGBA, GL_FLOAT, nullptr);
+
+  volumeBounds = kInitVolumeBounds;
+  noiseField.reset();
+  fluidSolver.reset();
+  boundsFitter.reset();
+  densityCascades.reset();
+
+  timePrevValid = false;
+}
+
+void ParticleSys::startBake(const fs::path &path, float tickRate) {
+  trajectoryBaker = std::make_shared<TrajectoryBaker>(programCache, path, kMaxParticles,
+                                                      kWorkGroupSizeX, volumeBounds, tickRate);
+}
+
+void ParticleSys::startPlayback(const fs::path &path) {
+  trajectoryPlayer =
+      std::make_shared<TrajectoryPlayer>(programCache, path, kMaxParticles, kWorkGroupSizeX);
+  trajectoryBaker = nullptr;
+}
+
+void ParticleSys::stopPlayback() {
+  trajectoryPlayer = nullptr;
+  reset();
+}
+
+void ParticleSys::startImport(const fs::path &path, bool downsample, float pointScale) {
+  auto import =
+      std::make_shared<PointCloudImport>(path, emitters->maxAlive, downsample, pointScale);
+  trajectoryPlayer = nullptr;
+  reset();
+  pointCloudImport = import;
+}
+
+void ParticleSys::finishImport() {
+  auto count = pointCloudImport->importCount;
+
+  // Imported points start at rest.
+  glBindBuffer(GL_COPY_READ_BUFFER, particles->getId());
+  glBindBuffer(GL_COPY_WRITE_BUFFER, particlesPrev->getId());
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * sizeof(Particle));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  // NOTE(ryan): They belong to the shell emitter, which update_cs keeps in bounds, and never
+  // expire. The volume is the cloud's bounding cube with a margin, like the bounds fitter's. The
+  // emitters are paused so they don't crowd out the cloud, reset() starts them again.
+  emitters->resetAlive(count, 0, std::numeric_limits<float>::infinity());
+  emitters->spawning = false;
+
+  if (count > 0) {
+    auto cloud = pointCloudImport->getBounds();
+    vec3 size = cloud.getSize();
+    vec3 extent(glm::max(size.x, size.y, size.z) * 0.55f + 0.01f);
+    volumeBounds = AxisAlignedBox(cloud.getCenter() - extent, cloud.getCenter() + extent);
+  }
+  noiseField.reset();
+  fluidSolver.reset();
+  boundsFitter.reset();
+  densityCascades.reset();
+
+  pointCloudImport = nullptr;
+}
+
+ComputeProg::Format ParticleSys::getUpdateShaderFormat(const fs::path &filepath) const {
+  return ComputeProg::Format()
+      .compute(filepath)
+      .define("WORK_GROUP_SIZE_X", std::to_string(kWorkGroupSizeX))
+      .define("PARTICLE_COUNT", std::to_string(kMaxParticles));
+}
+
 void ParticleSys::loadUpdateShaderMain(const fs::path &filepath) {
-  auto fmt = gl::GlslProg::Format()
-                 .compute(loadFile(filepath))
-                 .preprocess(true)
-                 .define("WORK_GROUP_SIZE_X", std::to_string(kWorkGroupSizeX))
-                 .define("PARTICLE_COUNT", std::to_string(kMaxParticles));
-  auto updateProg = gl::GlslProg::create(fmt);
+  // A reload that's still compiling is superseded, its result gets thrown away.
+  particleUpdateProgPending = programCache->createComputeAsync(getUpdateShaderFormat(filepath));
+}
+
+void ParticleSys::reloadUpdateShader(const fs::path &filepath) {
+  auto updateProg = programCache->createCompute(getUpdateShaderFormat(filepath));
+  FrameConstants::verifyLayout(*updateProg, "update_cs.glsl");
+
+  particleUpdateProg = updateProg;
+  particleUpdateProgPending = nullptr;
+  shaderCompile = true;
+}
+
+bool ParticleSys::swapUpdateShader() {
+  if (!particleUpdateProgPending || !particleUpdateProgPending->isReady()) return false;
+
+  auto pending = std::move(particleUpdateProgPending);
+  auto updateProg = pending->get();
+  FrameConstants::verifyLayout(*updateProg, "update_cs.glsl");
 
   particleUpdateProg = updateProg;
   shaderCompile = true;
+  return true;
 }
 
 } // splat
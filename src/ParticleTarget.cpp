@@ -0,0 +1,65 @@
+#include "ParticleTarget.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+ParticleTarget::ParticleTarget() : windowSize(0), downsample(0) {
+  auto fmt = gl::GlslProg::Format().vertex(app::loadAsset("fullscreen_vs.glsl"));
+  depthDownsampleProg =
+      gl::GlslProg::create(fmt.fragment(app::loadAsset("depth_downsample_fs.glsl")));
+  upsampleProg = gl::GlslProg::create(fmt.fragment(app::loadAsset("upsample_fs.glsl")));
+  emptyVao = gl::Vao::create();
+}
+
+void ParticleTarget::setSize(const ivec2 &windowSize, int downsample) {
+  if (fbo && windowSize == this->windowSize && downsample == this->downsample) return;
+
+  this->windowSize = windowSize;
+  this->downsample = downsample;
+
+  ivec2 size = glm::max((windowSize + downsample - 1) / downsample, ivec2(1));
+  auto colorFmt = gl::Texture2d::Format()
+                      .internalFormat(GL_RGBA16F)
+                      .minFilter(GL_NEAREST)
+                      .magFilter(GL_NEAREST);
+  fbo = gl::Fbo::create(size.x, size.y, gl::Fbo::Format().colorTexture(colorFmt).depthTexture());
+}
+
+void ParticleTarget::prepare(const gl::Texture2dRef &sceneDepth) {
+  {
+    gl::ScopedGlslProg scopedProg(depthDownsampleProg);
+    gl::ScopedTextureBind scopedSceneDepth(sceneDepth, 0);
+    gl::ScopedDepth scopedDepth(true, GL_ALWAYS);
+    gl::ScopedVao scopedVao(emptyVao);
+
+    depthDownsampleProg->uniform("sceneDepthTex", 0);
+    depthDownsampleProg->uniform("downsample", downsample);
+    gl::drawArrays(GL_TRIANGLES, 0, 3);
+  }
+
+  // The depth pass wrote garbage colour.
+  gl::clear(ColorA(0.0f, 0.0f, 0.0f, 0.0f), false);
+}
+
+void ParticleTarget::composite(const gl::Texture2dRef &sceneDepth) {
+  mat4 proj = gl::getProjectionMatrix();
+
+  gl::ScopedGlslProg scopedProg(upsampleProg);
+  gl::ScopedTextureBind scopedParticles(fbo->getColorTexture(), 0);
+  gl::ScopedTextureBind scopedParticleDepth(fbo->getDepthTexture(), 1);
+  gl::ScopedTextureBind scopedSceneDepth(sceneDepth, 2);
+  gl::ScopedDepth scopedDepth(false);
+  gl::ScopedVao scopedVao(emptyVao);
+
+  upsampleProg->uniform("particleTex", 0);
+  upsampleProg->uniform("particleDepthTex", 1);
+  upsampleProg->uniform("sceneDepthTex", 2);
+  upsampleProg->uniform("downsample", downsample);
+  upsampleProg->uniform("depthParams", vec2(proj[3][2], proj[2][2]));
+  upsampleProg->uniform("depthTolerance", depthTolerance);
+  gl::drawArrays(GL_TRIANGLES, 0, 3);
+}
+
+} // splat
@@ -0,0 +1,253 @@
+#include "PointCloudImport.hpp"
+
+#include "cinder/Log.h"
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace splat {
+
+namespace {
+
+const uint32_t kChunkParticles = 1 << 16;
+const uint32_t kMinParticlesPerWorker = 4096;
+const double kStepSeconds = 0.008;
+// PLY headers are a few hundred bytes, anything longer than this isn't one.
+const uint64_t kMaxHeaderSize = 1 << 16;
+
+const uint32_t kPropertySizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+bool getPropertyType(const std::string &name, PointCloudImport::PropertyType &type) {
+  static const struct {
+    const char *names[2];
+    PointCloudImport::PropertyType type;
+  } kTypes[] = {
+      {{"char", "int8"}, PointCloudImport::kInt8},
+      {{"uchar", "uint8"}, PointCloudImport::kUint8},
+      {{"short", "int16"}, PointCloudImport::kInt16},
+      {{"ushort", "uint16"}, PointCloudImport::kUint16},
+      {{"int", "int32"}, PointCloudImport::kInt32},
+      {{"uint", "uint32"}, PointCloudImport::kUint32},
+      {{"float", "float32"}, PointCloudImport::kFloat32},
+      {{"double", "float64"}, PointCloudImport::kFloat64},
+  };
+  for (const auto &t : kTypes) {
+    if (name == t.names[0] || name == t.names[1]) {
+      type = t.type;
+      return true;
+    }
+  }
+  return false;
+}
+
+struct Extents {
+  vec3 min = vec3(std::numeric_limits<float>::max());
+  vec3 max = vec3(std::numeric_limits<float>::lowest());
+
+  void include(const vec3 &p) {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+};
+
+template <typename T>
+T load(const uint8_t *ptr) {
+  T value;
+  std::memcpy(&value, ptr, sizeof(T));
+  return value;
+}
+
+// Integer colors are normalized over their type's range, positions are taken as is.
+float readProperty(const uint8_t *point, const PointCloudImport::Property &prop, bool normalize) {
+  const uint8_t *ptr = point + prop.offset;
+  switch (prop.type) {
+    case PointCloudImport::kInt8:
+      return load<int8_t>(ptr) / (normalize ? 127.0f : 1.0f);
+    case PointCloudImport::kUint8:
+      return load<uint8_t>(ptr) / (normalize ? 255.0f : 1.0f);
+    case PointCloudImport::kInt16:
+      return load<int16_t>(ptr) / (normalize ? 32767.0f : 1.0f);
+    case PointCloudImport::kUint16:
+      return load<uint16_t>(ptr) / (normalize ? 65535.0f : 1.0f);
+    case PointCloudImport::kInt32:
+      return float(load<int32_t>(ptr) / (normalize ? 2147483647.0 : 1.0));
+    case PointCloudImport::kUint32:
+      return float(load<uint32_t>(ptr) / (normalize ? 4294967295.0 : 1.0));
+    case PointCloudImport::kFloat32:
+      return load<float>(ptr);
+    case PointCloudImport::kFloat64:
+      return float(load<double>(ptr));
+  }
+  return 0.0f;
+}
+
+} // anonymous
+
+
+PointCloudImport::PointCloudImport(const fs::path &path, uint32_t capacity, bool downsample,
+                                   float pointScale)
+: file(path), staging(kChunkParticles * sizeof(Particle)), path(path), downsample(downsample),
+  pointScale(pointScale) {
+  if (path.extension() == ".ply") {
+    parsePlyHeader();
+  } else {
+    stride = 3 * sizeof(float);
+    pointCount = file.size / stride;
+    for (uint32_t i = 0; i < 3; ++i) {
+      position[i].offset = i * sizeof(float);
+      position[i].present = true;
+    }
+  }
+
+  if (dataOffset + pointCount * stride > file.size) {
+    throw std::runtime_error(path.filename().string() + " is shorter than its header says");
+  }
+  importCount = uint32_t(std::min(pointCount, uint64_t(capacity)));
+
+  CI_LOG_I("Importing " << importCount << " of " << pointCount << " points from " << path);
+}
+
+void PointCloudImport::parsePlyHeader() {
+  auto view = file.map(0, kMaxHeaderSize);
+  std::string text(reinterpret_cast<const char *>(view.data), size_t(view.size));
+
+  auto end = text.find("end_header");
+  auto lineEnd = end == std::string::npos ? end : text.find('\n', end);
+  if (text.compare(0, 3, "ply") != 0 || lineEnd == std::string::npos) {
+    throw std::runtime_error(path.filename().string() + " isn't a PLY file");
+  }
+  dataOffset = lineEnd + 1;
+
+  static const char *kPositionNames[] = {"x", "y", "z"};
+  static const char *kColorNames[] = {"red", "green", "blue", "alpha"};
+
+  std::istringstream lines(text.substr(0, end));
+  std::string line, element;
+  bool binaryLittleEndian = false;
+  while (std::getline(lines, line)) {
+    std::istringstream words(line);
+    std::string keyword;
+    words >> keyword;
+
+    if (keyword == "format") {
+      std::string format;
+      words >> format;
+      binaryLittleEndian = format == "binary_little_endian";
+    } else if (keyword == "element") {
+      uint64_t count = 0;
+      words >> element >> count;
+      if (element == "vertex") {
+        pointCount = count;
+      } else if (pointCount == 0 && count > 0) {
+        throw std::runtime_error("PLY elements before the vertices aren't supported");
+      }
+    } else if (keyword == "property" && element == "vertex") {
+      std::string typeName, name;
+      words >> typeName >> name;
+
+      PropertyType type;
+      if (typeName == "list" || !getPropertyType(typeName, type)) {
+        throw std::runtime_error("Unsupported PLY vertex property " + line);
+      }
+
+      for (int i = 0; i < 3; ++i) {
+        if (name == kPositionNames[i]) position[i] = {uint32_t(stride), type, true};
+      }
+      for (int i = 0; i < 4; ++i) {
+        if (name == kColorNames[i]) color[i] = {uint32_t(stride), type, true};
+      }
+      stride += kPropertySizes[type];
+    }
+  }
+
+  if (!binaryLittleEndian) throw std::runtime_error("Only binary little endian PLY is supported");
+  if (!position[0].present || !position[1].present || !position[2].present) {
+    throw std::runtime_error("PLY vertices have no x, y and z");
+  }
+}
+
+uint64_t PointCloudImport::getInputIndex(uint32_t outputIndex) const {
+  return downsample ? outputIndex * pointCount / importCount : outputIndex;
+}
+
+bool PointCloudImport::step(const gl::SsboRef &particles) {
+  Timer timer(true);
+  while (uploadedCount < importCount && timer.getSeconds() < kStepSeconds) {
+    uploadChunk(particles);
+  }
+
+  // NOTE(ryan): No need to wait on the last copies, anything reading the particles afterwards is
+  // ordered behind them on the GPU.
+  return uploadedCount == importCount;
+}
+
+void PointCloudImport::uploadChunk(const gl::SsboRef &particles) {
+  const uint32_t begin = uploadedCount;
+  const uint32_t end = std::min(begin + kChunkParticles, importCount);
+
+  // Only the span of the file this chunk samples is mapped.
+  const uint64_t firstInput = getInputIndex(begin);
+  const uint64_t lastInput = getInputIndex(end - 1);
+  auto view = file.map(dataOffset + firstInput * stride, (lastInput - firstInput + 1) * stride);
+
+  auto allocation = staging.allocate(kChunkParticles * sizeof(Particle), sizeof(Particle));
+  Particle *dst = reinterpret_cast<Particle *>(allocation.ptr);
+  auto convert = [&](uint32_t first, uint32_t last) {
+    Extents extents;
+    for (uint32_t o = first; o < last; ++o) {
+      const uint8_t *point = view.data + (getInputIndex(o) - firstInput) * stride;
+
+      Particle p;
+      p.position = vec3(readProperty(point, position[0], false),
+                        readProperty(point, position[1], false),
+                        readProperty(point, position[2], false));
+      p.scale = pointScale;
+      for (int i = 0; i < 4; ++i) {
+        p.color[i] = color[i].present ? readProperty(point, color[i], true) : 1.0f;
+      }
+      dst[o - begin] = p;
+      extents.include(p.position);
+    }
+    return extents;
+  };
+
+  // NOTE(ryan): The reads are mostly page faults into the mapping, so running them on every core
+  // keeps more of the file in flight as well as spreading the conversion.
+  uint32_t count = end - begin;
+  uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency());
+  workerCount = std::min(workerCount, std::max(1u, count / kMinParticlesPerWorker));
+
+  std::vector<std::future<Extents>> workers;
+  for (uint32_t w = 1; w < workerCount; ++w) {
+    workers.push_back(std::async(std::launch::async, convert, begin + count * w / workerCount,
+                                 begin + count * (w + 1) / workerCount));
+  }
+  auto extents = convert(begin, begin + count / workerCount);
+  for (auto &worker : workers) {
+    auto workerExtents = worker.get();
+    extents.include(workerExtents.min);
+    extents.include(workerExtents.max);
+  }
+  boundsMin = glm::min(boundsMin, extents.min);
+  boundsMax = glm::max(boundsMax, extents.max);
+
+  glBindBuffer(GL_COPY_READ_BUFFER, allocation.buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, particles->getId());
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, allocation.offset,
+                      begin * sizeof(Particle), count * sizeof(Particle));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  // Each chunk fills a region, so fence it and move on.
+  staging.endFrame();
+  uploadedCount = end;
+}
+
+} // splat
@@ -0,0 +1,303 @@
+#include "ProgramCache.hpp"
+#include "Utils.hpp"
+
+#include "cinder/Log.h"
+#include "cinder/Thread.h"
+#include "cinder/Timer.h"
+#include "cinder/gl/gl.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace splat {
+
+namespace {
+
+const uint32_t kMagic = 0x43425053; // "SPBC"
+// Version 2 added the variant hash to the file names.
+const uint32_t kVersion = 2;
+
+struct BinaryHeader {
+  uint32_t magic, version;
+  uint32_t binaryFormat, binarySize;
+  uint64_t sourceHash;
+};
+
+std::string getString(GLenum name) {
+  auto str = reinterpret_cast<const char *>(glGetString(name));
+  return str ? str : "";
+}
+
+std::string getProgramInfoLog(GLuint handle) {
+  GLint length = 0;
+  glGetProgramiv(handle, GL_INFO_LOG_LENGTH, &length);
+  std::string log(std::max(length, 1), '\0');
+  glGetProgramInfoLog(handle, length, nullptr, &log[0]);
+  return log;
+}
+
+std::string getShaderInfoLog(GLuint handle) {
+  GLint length = 0;
+  glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &length);
+  std::string log(std::max(length, 1), '\0');
+  glGetShaderInfoLog(handle, length, nullptr, &log[0]);
+  return log;
+}
+
+bool isLinked(GLuint handle) {
+  GLint status = GL_FALSE;
+  glGetProgramiv(handle, GL_LINK_STATUS, &status);
+  return status == GL_TRUE;
+}
+
+GLuint loadBinary(const fs::path &path, uint64_t sourceHash) {
+  std::ifstream file(path.string(), std::ios::binary);
+  if (!file) return 0;
+
+  BinaryHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) return 0;
+  if (header.magic != kMagic || header.version != kVersion || header.sourceHash != sourceHash) {
+    return 0;
+  }
+
+  std::vector<char> binary(header.binarySize);
+  if (!file.read(binary.data(), binary.size())) return 0;
+
+  GLuint handle = glCreateProgram();
+  glProgramBinary(handle, header.binaryFormat, binary.data(), GLsizei(binary.size()));
+  if (!isLinked(handle)) {
+    glDeleteProgram(handle);
+    return 0;
+  }
+  return handle;
+}
+
+bool hasCurrentHeader(const fs::path &path) {
+  std::ifstream file(path.string(), std::ios::binary);
+  BinaryHeader header;
+  return file.read(reinterpret_cast<char *>(&header), sizeof(header)) &&
+         header.magic == kMagic && header.version == kVersion;
+}
+
+std::string toHex(uint64_t value) {
+  std::ostringstream str;
+  str << std::hex << std::setw(16) << std::setfill('0') << value;
+  return str.str();
+}
+
+// Removes every other binary of the same program variant, i.e. ones built from older source.
+void removeStaleBinaries(const fs::path &path, const std::string &variantPrefix) {
+  try {
+    for (auto &entry : fs::directory_iterator(path.parent_path())) {
+      auto name = entry.path().filename().string();
+      if (name.compare(0, variantPrefix.size(), variantPrefix) == 0 && entry.path() != path) {
+        fs::remove(entry.path());
+      }
+    }
+  } catch (const std::exception &exc) {
+    CI_LOG_W("Failed to remove stale program binaries: " << exc.what());
+  }
+}
+
+void saveBinary(const fs::path &path, GLuint handle, uint64_t sourceHash) {
+  GLint size = 0;
+  glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &size);
+  if (size <= 0) return;
+
+  BinaryHeader header = {kMagic, kVersion, 0, 0, sourceHash};
+  std::vector<char> binary(size);
+  GLsizei length = 0;
+  GLenum binaryFormat = 0;
+  glGetProgramBinary(handle, size, &length, &binaryFormat, binary.data());
+  header.binaryFormat = binaryFormat;
+  header.binarySize = uint32_t(length);
+
+  std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(binary.data(), length);
+  if (!file) CI_LOG_W("Failed to write program binary " << path);
+}
+
+GLuint compile(const std::string &source, const fs::path &path) {
+  GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+  const char *sourcePtr = source.c_str();
+  glShaderSource(shader, 1, &sourcePtr, nullptr);
+  glCompileShader(shader);
+
+  GLint status = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  if (status != GL_TRUE) {
+    auto log = getShaderInfoLog(shader);
+    glDeleteShader(shader);
+    throw gl::GlslProgCompileExc(path.filename().string() + ": " + log, GL_COMPUTE_SHADER);
+  }
+
+  GLuint handle = glCreateProgram();
+  glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glAttachShader(handle, shader);
+  glLinkProgram(handle);
+  glDetachShader(handle, shader);
+  glDeleteShader(shader);
+
+  if (!isLinked(handle)) {
+    auto log = getProgramInfoLog(handle);
+    glDeleteProgram(handle);
+    throw gl::GlslProgLinkExc(path.filename().string() + ": " + log);
+  }
+  return handle;
+}
+
+} // anonymous
+
+
+ProgramCache::ProgramCache(const fs::path &cacheDirPath) : cacheDirPath(cacheDirPath) {
+  driverId = getString(GL_VENDOR) + "\n" + getString(GL_RENDERER) + "\n" + getString(GL_VERSION);
+
+  GLint formatCount = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+  if (formatCount == 0) {
+    CI_LOG_W("Driver supports no program binary formats, shader cache disabled");
+    this->cacheDirPath.clear();
+  } else if (!fs::exists(cacheDirPath)) {
+    fs::create_directories(cacheDirPath);
+  } else {
+    // NOTE(ryan): Binaries from older versions of the cache are never looked up again. Each save
+    // removes the binaries it replaces, so this only catches files left by older builds.
+    try {
+      for (auto &entry : fs::directory_iterator(cacheDirPath)) {
+        if (entry.path().extension() == ".bin" && !hasCurrentHeader(entry.path())) {
+          fs::remove(entry.path());
+        }
+      }
+    } catch (const std::exception &exc) {
+      CI_LOG_W("Failed to prune the shader cache: " << exc.what());
+    }
+  }
+
+  // Program objects and sync objects are shared with the main context.
+  auto compileContext = gl::Context::create(gl::context());
+  compileThread = std::thread(&ProgramCache::compileThreadFn, this, compileContext);
+}
+
+ProgramCache::~ProgramCache() {
+  {
+    std::lock_guard<std::mutex> lock(compileMutex);
+    compileStop = true;
+  }
+  compileCond.notify_one();
+  compileThread.join();
+}
+
+GLuint ProgramCache::build(const ComputeProg::Format &format) {
+  gl::ShaderPreprocessor preprocessor;
+  for (const auto &define : format.defines) {
+    preprocessor.addDefine(define.first, define.second);
+  }
+  auto source = preprocessor.parse(format.path);
+
+  uint64_t sourceHash = hashFnv1a(source.data(), source.size());
+  sourceHash = hashFnv1a(driverId.data(), driverId.size(), sourceHash);
+
+  // NOTE(ryan): One file per variant (the path plus its defines), named by the source hash. Hot
+  // reloading changes the source hash, and saving the new binary removes the old ones, so the
+  // cache holds one binary per variant rather than one per edit.
+  std::string variantPrefix;
+  fs::path binaryPath;
+  if (!cacheDirPath.empty()) {
+    auto variantId = format.path.string();
+    for (const auto &define : format.defines) {
+      variantId += "\n" + define.first + "=" + define.second;
+    }
+    uint64_t variantHash = hashFnv1a(variantId.data(), variantId.size());
+
+    variantPrefix = format.path.stem().string() + "_" + toHex(variantHash) + "_";
+    binaryPath = cacheDirPath / (variantPrefix + toHex(sourceHash) + ".bin");
+
+    if (GLuint handle = loadBinary(binaryPath, sourceHash)) {
+      ++hitCount;
+      return handle;
+    }
+  }
+
+  Timer timer(true);
+  GLuint handle = compile(source, format.path);
+  timer.stop();
+
+  ++missCount;
+  compileMicros += uint64_t(timer.getSeconds() * 1e6);
+  CI_LOG_I("Compiled " << format.path.filename() << " in " << timer.getSeconds() << "s");
+
+  if (!binaryPath.empty()) {
+    saveBinary(binaryPath, handle, sourceHash);
+    removeStaleBinaries(binaryPath, variantPrefix);
+  }
+
+  return handle;
+}
+
+ComputeProgRef ProgramCache::createCompute(const ComputeProg::Format &format) {
+  return std::make_shared<ComputeProg>(build(format));
+}
+
+PendingComputeProgRef ProgramCache::createComputeAsync(const ComputeProg::Format &format) {
+  auto pending = std::make_shared<PendingComputeProg>(format);
+  {
+    std::lock_guard<std::mutex> lock(compileMutex);
+    compileQueue.push_back(pending);
+  }
+  compileCond.notify_one();
+  return pending;
+}
+
+void ProgramCache::compileThreadFn(gl::ContextRef context) {
+  ThreadSetup threadSetup;
+  context->makeCurrent();
+
+  while (true) {
+    PendingComputeProgRef pending;
+    {
+      std::unique_lock<std::mutex> lock(compileMutex);
+      compileCond.wait(lock, [this] { return compileStop || !compileQueue.empty(); });
+      if (compileStop) break;
+      pending = compileQueue.front();
+      compileQueue.pop_front();
+    }
+
+    try {
+      pending->handle = build(pending->format);
+      pending->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    } catch (...) {
+      pending->error = std::current_exception();
+    }
+
+    // The fence has to reach the GPU before the main context can wait on it.
+    glFlush();
+    pending->done = true;
+  }
+}
+
+
+PendingComputeProg::~PendingComputeProg() {
+  if (fence) glDeleteSync(fence);
+  if (handle) glDeleteProgram(handle);
+}
+
+bool PendingComputeProg::isReady() {
+  if (!done) return false;
+  if (fence) {
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  return true;
+}
+
+ComputeProgRef PendingComputeProg::get() {
+  if (error) std::rethrow_exception(error);
+  auto prog = std::make_shared<ComputeProg>(handle);
+  handle = 0;
+  return prog;
+}
+
+} // splat
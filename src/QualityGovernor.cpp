@@ -0,0 +1,193 @@
+#include "QualityGovernor.hpp"
+
+#include "cinder/Log.h"
+
+#include <sstream>
+
+namespace splat {
+
+static const float kParticleFractions[] = {1.0f, 0.75f, 0.5f, 0.35f, 0.25f};
+static const int kDensityIntervals[] = {1, 2, 4};
+static const int kDownsamples[] = {1, 2, 4};
+static const float kPointSizeScales[] = {1.0f, 0.85f, 0.7f};
+
+static const int kLevelCounts[] = {
+    int(sizeof(kParticleFractions) / sizeof(float)), int(sizeof(kDensityIntervals) / sizeof(int)),
+    int(sizeof(kDownsamples) / sizeof(int)), int(sizeof(kPointSizeScales) / sizeof(float)),
+};
+
+// Which knob to step down first, by which side of the frame costs more.
+static const QualityGovernor::Knob kDrawBoundOrder[] = {
+    QualityGovernor::kKnobDownsample, QualityGovernor::kKnobPointSize,
+    QualityGovernor::kKnobParticles, QualityGovernor::kKnobDensityInterval};
+static const QualityGovernor::Knob kSimBoundOrder[] = {
+    QualityGovernor::kKnobDensityInterval, QualityGovernor::kKnobParticles,
+    QualityGovernor::kKnobDownsample, QualityGovernor::kKnobPointSize};
+
+static const float kSmoothing = 0.1f;
+
+
+QualityGovernor::QualityGovernor() : frameSlot(0) {
+  for (uint32_t i = 0; i < kFrameLatency; ++i) {
+    glGenQueries(kStageCount + 1, queries[i]);
+    stagesMarked[i] = 0;
+    slotFrameIds[i] = 0;
+  }
+  for (auto &ms : stageMilliseconds) ms = 0.0f;
+  reset();
+}
+
+QualityGovernor::~QualityGovernor() {
+  for (auto &frameQueries : queries) {
+    glDeleteQueries(kStageCount + 1, frameQueries);
+  }
+}
+
+void QualityGovernor::reset() {
+  for (auto &level : levels) level = 0;
+  stepCount = 0;
+  overFrames = underFrames = cooldownFrames = 0;
+  floorLogged = false;
+  updateSettings();
+}
+
+void QualityGovernor::mark(uint32_t index) {
+  glQueryCounter(queries[frameSlot][index], GL_TIMESTAMP);
+  stagesMarked[frameSlot] |= 1u << index;
+}
+
+void QualityGovernor::beginStage(Stage stage) {
+  mark(stage);
+}
+
+void QualityGovernor::endFrame() {
+  mark(kStageCount);
+  slotFrameIds[frameSlot] = frameId++;
+  frameSlot = (frameSlot + 1) % kFrameLatency;
+
+  // NOTE(ryan): The slot about to be reused is the oldest frame in flight.
+  if (readTimings()) {
+    float total = 0.0f;
+    for (auto ms : stageMilliseconds) total += ms;
+    smoothedMilliseconds = smoothedMilliseconds > 0.0f
+                               ? glm::mix(smoothedMilliseconds, total, kSmoothing)
+                               : total;
+    if (enabled) control();
+  }
+  stagesMarked[frameSlot] = 0;
+}
+
+bool QualityGovernor::readTimings() {
+  const uint32_t allMarked = (1u << (kStageCount + 1)) - 1;
+  if (stagesMarked[frameSlot] != allMarked) return false;
+
+  GLuint available = GL_FALSE;
+  glGetQueryObjectuiv(queries[frameSlot][kStageCount], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) return false;
+
+  GLuint64 timestamps[kStageCount + 1];
+  for (uint32_t i = 0; i <= kStageCount; ++i) {
+    glGetQueryObjectui64v(queries[frameSlot][i], GL_QUERY_RESULT, &timestamps[i]);
+  }
+  for (uint32_t i = 0; i < kStageCount; ++i) {
+    stageMilliseconds[i] = float(double(timestamps[i + 1] - timestamps[i]) / 1e6);
+  }
+  timedFrameId = slotFrameIds[frameSlot];
+  return true;
+}
+
+void QualityGovernor::control() {
+  if (cooldownFrames > 0) {
+    --cooldownFrames;
+    return;
+  }
+
+  bool over = smoothedMilliseconds > targetMilliseconds;
+  bool under = smoothedMilliseconds < targetMilliseconds * recoverRatio;
+  overFrames = over ? overFrames + 1 : 0;
+  underFrames = under ? underFrames + 1 : 0;
+
+  if (overFrames >= uint32_t(degradeFrames)) {
+    overFrames = 0;
+
+    float simMilliseconds = stageMilliseconds[kStageSimulation] + stageMilliseconds[kStageSort];
+    const Knob *order =
+        simMilliseconds > stageMilliseconds[kStageDraw] ? kSimBoundOrder : kDrawBoundOrder;
+
+    for (int i = 0; i < kKnobCount; ++i) {
+      Knob knob = order[i];
+      if (levels[knob] + 1 >= kLevelCounts[knob] || stepCount == kMaxSteps) continue;
+
+      ++levels[knob];
+      steps[stepCount++] = knob;
+      updateSettings();
+      log(std::string("lowered ") + getKnobName(knob));
+      cooldownFrames = cooldown;
+      return;
+    }
+
+    if (!floorLogged) log("at minimum quality, still over budget");
+    floorLogged = true;
+  } else if (underFrames >= uint32_t(recoverFrames) && stepCount > 0) {
+    underFrames = 0;
+
+    floorLogged = false;
+    Knob knob = steps[--stepCount];
+    --levels[knob];
+    updateSettings();
+    log(std::string("raised ") + getKnobName(knob));
+    cooldownFrames = cooldown;
+  }
+}
+
+void QualityGovernor::updateSettings() {
+  settings.particleFraction = kParticleFractions[levels[kKnobParticles]];
+  settings.densityInterval = kDensityIntervals[levels[kKnobDensityInterval]];
+  settings.downsample = kDownsamples[levels[kKnobDownsample]];
+  settings.pointSizeScale = kPointSizeScales[levels[kKnobPointSize]];
+}
+
+void QualityGovernor::log(const std::string &decision) {
+  std::ostringstream str;
+  str.precision(3);
+  str << decision << " at " << smoothedMilliseconds << "ms (target " << targetMilliseconds;
+  for (int i = 0; i < kStageCount; ++i) {
+    str << ", " << getStageName(Stage(i)) << " " << stageMilliseconds[i];
+  }
+  str << "): particles " << settings.particleFraction << ", density every "
+      << settings.densityInterval << ", downsample " << settings.downsample << ", point size "
+      << settings.pointSizeScale;
+
+  lastDecision = str.str();
+  CI_LOG_I("Quality governor " << lastDecision);
+}
+
+const char *QualityGovernor::getStageName(Stage stage) {
+  switch (stage) {
+    case kStageSimulation:
+      return "simulation";
+    case kStageSort:
+      return "sort";
+    case kStageDraw:
+      return "draw";
+    default:
+      return "";
+  }
+}
+
+const char *QualityGovernor::getKnobName(Knob knob) {
+  switch (knob) {
+    case kKnobParticles:
+      return "particle count";
+    case kKnobDensityInterval:
+      return "density rate";
+    case kKnobDownsample:
+      return "resolution";
+    case kKnobPointSize:
+      return "point size";
+    default:
+      return "";
+  }
+}
+
+} // splat
@@ -0,0 +1,115 @@
+#include "Replay.hpp"
+
+#include "cinder/Log.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace splat {
+
+namespace {
+
+const uint32_t kMagic = 0x43525053; // "SPRC"
+const uint32_t kVersion = 1;
+
+struct Header {
+  uint32_t magic, version;
+  float tickRate;
+  uint32_t pad;
+};
+
+// Marks a frame without a time yet.
+const float kNoTime = -1.0f;
+
+float percentile(std::vector<float> values, float p) {
+  values.erase(std::remove(values.begin(), values.end(), kNoTime), values.end());
+  if (values.empty()) return 0.0f;
+  auto nth = values.begin() + size_t(p * (values.size() - 1));
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+} // anonymous
+
+
+ReplayWriter::ReplayWriter(const fs::path &path, float tickRate)
+: file(path.string(), std::ios::binary | std::ios::trunc) {
+  Header header = {kMagic, kVersion, tickRate, 0};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (!file) CI_LOG_W("Failed to write recording " << path);
+}
+
+void ReplayWriter::writeFrame(const ReplayFrame &frame, const std::vector<ReplayTick> &ticks) {
+  ReplayFrame record = frame;
+  record.tickCount = uint32_t(ticks.size());
+  file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+  file.write(reinterpret_cast<const char *>(ticks.data()), ticks.size() * sizeof(ReplayTick));
+}
+
+
+ReplayReader::ReplayReader(const fs::path &path) : file(path.string(), std::ios::binary) {
+  Header header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    throw std::runtime_error("Can't read recording " + path.string());
+  }
+  if (header.magic != kMagic || header.version != kVersion) {
+    throw std::runtime_error(path.string() + " is not a recording, or from another version");
+  }
+  tickRate = header.tickRate;
+}
+
+bool ReplayReader::readFrame(ReplayFrame &frame, std::vector<ReplayTick> &ticks) {
+  if (!file.read(reinterpret_cast<char *>(&frame), sizeof(frame))) return false;
+
+  ticks.resize(frame.tickCount);
+  if (!file.read(reinterpret_cast<char *>(ticks.data()), ticks.size() * sizeof(ReplayTick))) {
+    return false;
+  }
+  ++frameIndex;
+  return true;
+}
+
+
+void ReplayStats::addFrames(uint32_t count) {
+  if (count <= frameMilliseconds.size()) return;
+  frameMilliseconds.resize(count, kNoTime);
+  gpuMilliseconds.resize(count, kNoTime);
+}
+
+void ReplayStats::setFrame(uint32_t frame, float frameMs) {
+  addFrames(frame + 1);
+  frameMilliseconds[frame] = frameMs;
+}
+
+void ReplayStats::setGpu(uint32_t frame, float gpuMs) {
+  addFrames(frame + 1);
+  gpuMilliseconds[frame] = gpuMs;
+}
+
+void ReplayStats::report(const fs::path &csvPath) const {
+  std::ofstream file(csvPath.string(), std::ios::trunc);
+  file << "frame,frame_ms,gpu_ms\n";
+  for (size_t i = 0; i < frameMilliseconds.size(); ++i) {
+    file << i << ",";
+    if (frameMilliseconds[i] != kNoTime) file << frameMilliseconds[i];
+    file << ",";
+    if (gpuMilliseconds[i] != kNoTime) file << gpuMilliseconds[i];
+    file << "\n";
+  }
+
+  size_t count = 0;
+  float sum = 0.0f;
+  for (auto ms : frameMilliseconds) {
+    if (ms == kNoTime) continue;
+    sum += ms;
+    ++count;
+  }
+  float mean = count ? sum / count : 0.0f;
+  CI_LOG_I("Replay of " << count << " frames: mean " << mean << "ms, median "
+                        << percentile(frameMilliseconds, 0.5f) << "ms, 95th "
+                        << percentile(frameMilliseconds, 0.95f) << "ms, 99th "
+                        << percentile(frameMilliseconds, 0.99f) << "ms, GPU median "
+                        << percentile(gpuMilliseconds, 0.5f) << "ms. Written to " << csvPath);
+}
+
+} // splat
@@ -12,14 +12,17 @@ namespace splat {
 
 using namespace ci;
 
-RadixSort::RadixSort(uint32_t elemCount, uint32_t blockSize)
+RadixSort::RadixSort(const ProgramCacheRef &programCache, uint32_t elemCount, uint32_t blockSize)
 : elemCount(elemCount), blockSize(blockSize) {
-  auto fmt = gl::GlslProg::Format();
+  auto fmt = ComputeProg::Format();
 
-  scanProg = gl::GlslProg::create(fmt.compute(app::loadAsset("scan_cs.glsl")));
-  scanFirstProg = gl::GlslProg::create(fmt.compute(app::loadAsset("scan_first_cs.glsl")));
-  resolveProg = gl::GlslProg::create(fmt.compute(app::loadAsset("scan_resolve_cs.glsl")));
-  reorderProg = gl::GlslProg::create(fmt.compute(app::loadAsset("scan_reorder_cs.glsl")));
+  scanProg = programCache->createCompute(fmt.compute(app::getAssetPath("scan_cs.glsl")));
+  scanFirstProg = programCache->createCompute(fmt.compute(app::getAssetPath("scan_first_cs.glsl")));
+  resolveProg = programCache->createCompute(fmt.compute(app::getAssetPath("scan_resolve_cs.glsl")));
+  reorderProg = programCache->createCompute(fmt.compute(app::getAssetPath("scan_reorder_cs.glsl")));
+
+  FrameConstants::verifyLayout(*scanFirstProg, "scan_first_cs.glsl");
+  bitOffsetLoc = scanFirstProg->getUniformLocation("bitOffset");
 
   {
     scanLevelCount = 0;
@@ -49,31 +52,10 @@ RadixSort::RadixSort(uint32_t elemCount, uint32_t blockSize)
   }
 }
 
-void RadixSort::sortBits(GLuint inputBufId, GLuint outputBufId, int bitOffset, const vec3 &axis,
-                         float zMin, float zMax) {
+void RadixSort::scanBlockSums(uint32_t blockCount) {
   // Keep track of which dispatch sizes we used to make the resolve steps simpler.
   std::vector<uint32_t> dispatchSizes(scanLevelCount);
-
-  uint32_t blockCount = elemCount / blockSize;
-
-  {
-    // First pass. Compute 16-bit unsigned depth and apply first pass of scan algorithm.
-
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputBufId);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scanBuffers.front()->getId());
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sumBuffers.front()->getId());
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, flagsBuffer->getId());
-
-    scanFirstProg->bind();
-    scanFirstProg->uniform("bitOffset", bitOffset);
-    scanFirstProg->uniform("axis", axis);
-    scanFirstProg->uniform("zMin", zMin);
-    scanFirstProg->uniform("zMax", zMax);
-
-    dispatchSizes[0] = blockCount;
-    glDispatchCompute(blockCount, 1, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-  }
+  dispatchSizes[0] = blockCount;
 
   {
     // If we processed more than one work group of data, we're not done, so scan buf_sums[0] and
@@ -119,6 +101,27 @@ void RadixSort::sortBits(GLuint inputBufId, GLuint outputBufId, int bitOffset, c
       glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
   }
+}
+
+void RadixSort::sortBits(GLuint inputBufId, GLuint outputBufId, int bitOffset) {
+  uint32_t blockCount = elemCount / blockSize;
+
+  {
+    // First pass. Compute 16-bit unsigned depth and apply first pass of scan algorithm.
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputBufId);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scanBuffers.front()->getId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sumBuffers.front()->getId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, flagsBuffer->getId());
+
+    scanFirstProg->bind();
+    glProgramUniform1i(scanFirstProg->getHandle(), bitOffsetLoc, bitOffset);
+
+    glDispatchCompute(blockCount, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  scanBlockSums(blockCount);
 
   {
     // We can now reorder our input properly.
@@ -142,15 +145,32 @@ void RadixSort::sortBits(GLuint inputBufId, GLuint outputBufId, int bitOffset, c
   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, 0);
 }
 
-void RadixSort::sort(GLuint inputBufId, GLuint outputBufId, const vec3 &axis, float zMin,
-                     float zMax) {
+void RadixSort::scan(GLuint inputBufId, uint32_t count) {
+  uint32_t blockCount = count / blockSize;
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputBufId);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, scanBuffers.front()->getId());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, sumBuffers.front()->getId());
+
+  scanProg->bind();
+  glDispatchCompute(blockCount, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  scanBlockSums(blockCount);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, 0);
+}
+
+void RadixSort::sort(GLuint inputBufId, GLuint outputBufId) {
   GLuint sortedBufId = sortedBuffer->getId();
 
-  sortBits(inputBufId, sortedBufId, 0, axis, zMin, zMax);
+  sortBits(inputBufId, sortedBufId, 0);
   std::swap(inputBufId, sortedBufId);
 
   for (uint32_t i = 1; i < 8; ++i) {
-    sortBits(inputBufId, outputBufId, i * 2, axis, zMin, zMax);
+    sortBits(inputBufId, outputBufId, i * 2);
     std::swap(inputBufId, outputBufId);
   }
 
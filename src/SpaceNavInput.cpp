@@ -0,0 +1,59 @@
+#include "SpaceNavInput.hpp"
+
+#include "cinder/Thread.h"
+
+#include "3DConnexion.h"
+
+#include <chrono>
+
+#include <windows.h>
+
+namespace splat {
+
+SpaceNavInput::SpaceNavInput() {
+  pollThread = std::thread(&SpaceNavInput::pollThreadFn, this);
+}
+
+SpaceNavInput::~SpaceNavInput() {
+  pollStop = true;
+  pollThread.join();
+}
+
+double SpaceNavInput::now() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void SpaceNavInput::push(const Sample &sample) {
+  if (!queue.push(sample)) ++droppedCount;
+}
+
+void SpaceNavInput::pollThreadFn() {
+  ThreadSetup threadSetup;
+
+  HWND hwnd = CreateWindowExW(0, L"STATIC", L"SpaceNavInput", 0, 0, 0, 0, 0, HWND_MESSAGE,
+                              nullptr, GetModuleHandleW(nullptr), nullptr);
+  connexion::Device::initialize(hwnd);
+
+  const auto &ids = connexion::Device::getAllDeviceIds();
+  if (!ids.empty()) {
+    auto device = connexion::Device::create(ids.front());
+    device->getMotionSignal().connect([this](const connexion::MotionEvent &event) {
+      push({now(), event.translation, event.rotation, false});
+    });
+    device->getButtonDownSignal().connect(
+        [this](const connexion::ButtonDownEvent &event) { push({now(), vec3(), vec3(), true}); });
+    connected = true;
+
+    while (!pollStop) {
+      device->update();
+      // Sleep until the next message arrives, waking every millisecond to check pollStop.
+      MsgWaitForMultipleObjects(0, nullptr, FALSE, 1, QS_ALLINPUT);
+    }
+  }
+
+  connexion::Device::shutdown();
+  DestroyWindow(hwnd);
+}
+
+} // splat
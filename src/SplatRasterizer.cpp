@@ -0,0 +1,151 @@
+#include "SplatRasterizer.hpp"
+#include "Utils.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+static const uint32_t kTileSize = 16;
+static const uint32_t kEntriesPerParticle = 8;
+
+static const GLuint kCountBinding = 14;
+static const GLuint kRangeBinding = 15;
+static const GLuint kEntryBinding = 16;
+
+
+SplatRasterizer::SplatRasterizer(const ProgramCacheRef &programCache,
+                                 const RadixSortRef &radixSort, uint32_t maxParticles,
+                                 uint32_t workGroupSize)
+: radixSort(radixSort), viewportSize(0), tileRes(0), tileCount(0), scanCount(0),
+  entryCapacity(kEntriesPerParticle * maxParticles), workGroupSize(workGroupSize) {
+  {
+    auto fmt = ComputeProg::Format().define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize));
+    countProg = programCache->createCompute(fmt.compute(app::getAssetPath("tile_count_cs.glsl")));
+    rangesProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("tile_ranges_cs.glsl")));
+    binProg = programCache->createCompute(fmt.compute(app::getAssetPath("tile_bin_cs.glsl")));
+    rasterProg =
+        programCache->createCompute(fmt.compute(app::getAssetPath("tile_raster_cs.glsl")));
+  }
+
+  // NOTE(ryan): Most splats are a pixel or two across and land in one tile. The budget is spent on
+  // the big ones up close, anything past it is dropped (see tile_ranges_cs.glsl).
+  entryBuffer = gl::Ssbo::create(entryCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+}
+
+void SplatRasterizer::setViewport(const ivec2 &size) {
+  if (size == viewportSize) return;
+
+  viewportSize = size;
+  tileRes = (uvec2(size) + kTileSize - 1u) / kTileSize;
+
+  uint32_t blockSize = radixSort->blockSize;
+  tileCount = tileRes.x * tileRes.y;
+  scanCount = (tileCount + blockSize - 1) / blockSize * blockSize;
+
+  countBuffer = gl::Ssbo::create(scanCount * sizeof(uvec4), nullptr, GL_DYNAMIC_COPY);
+  rangeBuffer = gl::Ssbo::create(scanCount * sizeof(uvec2), nullptr, GL_DYNAMIC_COPY);
+
+  auto fmt = gl::Texture2d::Format()
+                 .immutableStorage()
+                 .internalFormat(GL_RGBA16F)
+                 .minFilter(GL_NEAREST)
+                 .magFilter(GL_NEAREST);
+  targetTexture = gl::Texture2d::create(size.x, size.y, fmt);
+}
+
+void SplatRasterizer::setUniforms(const ComputeProgRef &prog, float pointSize,
+                                  float cullDistance) const {
+  prog->uniform("modelViewProjection", gl::getModelViewProjection());
+  prog->uniform("viewportSize", vec2(viewportSize));
+  prog->uniform("tileRes", tileRes);
+  prog->uniform("pointSize", pointSize);
+  prog->uniform("cullDistance", cullDistance);
+}
+
+void SplatRasterizer::draw(const gl::SsboRef &particlesSorted, const ParticleEmitters &emitters,
+                           const gl::TextureRef &splatTexture, float pointSize,
+                           float cullDistance) {
+  setViewport(gl::getViewport().second);
+
+  // The padding up to scanCount has to be zero too.
+  auto clearCounts = [this] {
+    countBuffer->bind();
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, scanCount * sizeof(uvec4),
+                         GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    countBuffer->unbind();
+  };
+
+  particlesSorted->bindBase(0);
+  emitters.bindBuffers();
+  countBuffer->bindBase(kCountBinding);
+  rangeBuffer->bindBase(kRangeBinding);
+  entryBuffer->bindBase(kEntryBinding);
+
+  // NOTE(ryan): Count splats per tile.
+  {
+    clearCounts();
+
+    countProg->bind();
+    setUniforms(countProg, pointSize, cullDistance);
+
+    emitters.dispatchAlive();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  radixSort->scan(countBuffer->getId(), scanCount);
+
+  // NOTE(ryan): Turn the inclusive scan into each tile's first entry and count.
+  {
+    rangesProg->bind();
+    setUniforms(rangesProg, pointSize, cullDistance);
+    rangesProg->uniform("scanBlockSize", radixSort->blockSize);
+    rangesProg->uniform("entryCapacity", entryCapacity);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, radixSort->scanBuffers.front()->getId());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, radixSort->sumBuffers.front()->getId());
+
+    glDispatchCompute((tileCount + workGroupSize - 1) / workGroupSize, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  // RadixSort's scan and the ranges pass use the low bindings, put them back.
+  particlesSorted->bindBase(0);
+  emitters.bindBuffers();
+
+  // NOTE(ryan): Scatter splat ranks into their tiles.
+  {
+    clearCounts();
+
+    binProg->bind();
+    setUniforms(binProg, pointSize, cullDistance);
+
+    emitters.dispatchAlive();
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+
+  // NOTE(ryan): Blend each tile.
+  {
+    gl::ScopedTextureBind scopedSplatTex(splatTexture, 0);
+
+    rasterProg->bind();
+    setUniforms(rasterProg, pointSize, cullDistance);
+    rasterProg->uniform("splatTex", 0);
+
+    glBindImageTexture(0, targetTexture->getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute(tileRes.x, tileRes.y, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  }
+
+  entryBuffer->unbindBase();
+  rangeBuffer->unbindBase();
+  countBuffer->unbindBase();
+  emitters.unbindBuffers();
+  particlesSorted->unbindBase();
+
+  drawOverViewport(targetTexture);
+}
+
+} // splat
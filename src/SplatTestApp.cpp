@@ -8,12 +8,19 @@
 #include "cinder/gl/Ssbo.h"
 #include "cinder/gl/gl.h"
 
-#include "3DConnexion.h"
 #include "CinderImGui.h"
 #include "Watchdog.h"
 
 #include "BodyCam.hpp"
+#include "CameraConstants.hpp"
+#include "Checkpoint.hpp"
+#include "FixedTimestep.hpp"
 #include "ParticleSys.hpp"
+#include "ProgramCache.hpp"
+#include "QualityGovernor.hpp"
+#include "Replay.hpp"
+#include "SpaceNavInput.hpp"
+#include "UploadRing.hpp"
 #include "Utils.hpp"
 
 
@@ -25,17 +32,61 @@ namespace splat {
 
 
 class SplatTestApp : public App {
+  ProgramCacheRef programCache;
+  // Per-frame constants and emitters are written into this, ended once a frame in draw().
+  UploadRingRef uploadRing;
   std::unique_ptr<ParticleSys> particleSys;
   fs::path particleUpdateMainFilepath;
 
-  connexion::DeviceRef spaceNav;
+  SpaceNavInputRef spaceNavInput;
 
   CameraPersp camera;
   Body3 cameraBody;
+  // Latest 3D mouse deflection, and its integral since it was last averaged for the ticks.
   vec3 cameraTranslation, cameraRotation;
+  vec3 cameraTranslationSum, cameraRotationSum;
+  double inputTimePrev = 0.0, inputSumSeconds = 0.0;
+
+  // The camera drawn with, latched at the start of draw() from the newest input.
+  CameraPersp drawCamera;
+  CameraConstantsRef cameraConstants;
+  bool lateLatchEnabled = true;
+
+  QualityGovernorRef governor;
+
+  FixedTimestep timestep;
+  double frameTimePrev = 0.0;
+  int frameTickCount = 0;
+
+  // Recording fills in the current frame as it goes, replay reads it back.
+  ReplayWriterRef replayWriter;
+  ReplayReaderRef replayReader;
+  ReplayFrame replayFrame;
+  std::vector<ReplayTick> replayTicks;
+  ReplayStats replayStats;
+  // The governor's frameId on the replay's first frame, to match up its GPU timings.
+  uint32_t replayFirstFrameId = 0;
+  std::string replayStatus;
+  // Set from the GUI, recording starts at the top of the next update.
+  bool recordPending = false;
+
+  CheckpointWriterRef checkpointWriter;
+  std::string checkpointStatus;
+
+  std::string trajectoryStatus;
+
+  char importPath[512] = "";
+  bool importDownsample = true;
+  float importPointScale = 2.0f;
+  std::string importStatus;
+
+  std::string forceFieldStatus;
+
+  gl::FboRef sceneFbo;
 
   std::string updateShaderError;
   bool renderDebugGraphics = false;
+  bool renderOverdraw = false;
 
 public:
   void setup() override;
@@ -46,7 +97,22 @@ public:
   void keyDown(KeyEvent event) override;
 
   void updateGui();
+  void applyQuality(const QualityGovernor::Settings &settings);
+  void drawScene();
   void resetCamera();
+  void pollInput();
+  void getCameraImpulses(const vec3 &translation, const vec3 &rotation, vec3 &impulse,
+                         quat &angularImpulse) const;
+  void latchCamera();
+  void recordFrame();
+
+  fs::path getRecordingsPath();
+  fs::path getCheckpointPath();
+  fs::path getTrajectoryCachePath();
+  void startRecording();
+  void startReplay();
+  void stopReplay();
+  void updateReplay(double frameSeconds);
 };
 
 
@@ -59,37 +125,25 @@ void SplatTestApp::resetCamera() {
 void SplatTestApp::setup() {
   resetCamera();
 
-  {
-    connexion::Device::initialize(getRenderer()->getHwnd());
-    const auto &ids = connexion::Device::getAllDeviceIds();
-    if (!ids.empty()) {
-      spaceNav = connexion::Device::create(ids.front());
-      spaceNav->getMotionSignal().connect([this](const connexion::MotionEvent &event) {
-        cameraTranslation = event.translation;
-        cameraRotation = event.rotation;
-      });
-      spaceNav->getButtonDownSignal().connect(
-          [this](const connexion::ButtonDownEvent &event) { resetCamera(); });
-    }
-  }
+  spaceNavInput = std::make_shared<SpaceNavInput>();
+  inputTimePrev = SpaceNavInput::now();
 
-  particleSys = std::make_unique<ParticleSys>();
+  programCache = std::make_shared<ProgramCache>(getAppPath().parent_path() / "shader_cache");
+  uploadRing = std::make_shared<UploadRing>(1 << 18);
+  particleSys = std::make_unique<ParticleSys>(programCache, uploadRing);
   particleUpdateMainFilepath = getAssetPath("update_cs.glsl");
+  governor = std::make_shared<QualityGovernor>();
+  cameraConstants = std::make_shared<CameraConstants>(uploadRing);
 
   wd::watch(particleUpdateMainFilepath, [this](const fs::path &filepath) {
-    updateShaderError.clear();
-    try {
-      particleSys->loadUpdateShaderMain(filepath);
-    } catch (const gl::GlslProgCompileExc &exc) {
-      updateShaderError = exc.what();
-    }
+    particleSys->loadUpdateShaderMain(filepath);
   });
 
   ui::initialize(ui::Options().autoRender(false));
 }
 
 void SplatTestApp::cleanup() {
-  connexion::Device::shutdown();
+  spaceNavInput.reset();
 }
 
 
@@ -98,26 +152,280 @@ void SplatTestApp::resize() {
 }
 
 
+// NOTE(ryan): Drains the 3D mouse samples. The device reports a deflection that holds until the
+// next sample, so integrating it over time and averaging over the frame takes in every sample,
+// however many arrive between frames.
+void SplatTestApp::pollInput() {
+  double time = SpaceNavInput::now();
+
+  SpaceNavInput::Sample sample;
+  while (spaceNavInput->pop(sample)) {
+    if (sample.button) {
+      resetCamera();
+      continue;
+    }
+
+    double t = glm::clamp(sample.time, inputTimePrev, time);
+    cameraTranslationSum += cameraTranslation * float(t - inputTimePrev);
+    cameraRotationSum += cameraRotation * float(t - inputTimePrev);
+    inputSumSeconds += t - inputTimePrev;
+    inputTimePrev = t;
+
+    cameraTranslation = sample.translation;
+    cameraRotation = sample.rotation;
+  }
+
+  cameraTranslationSum += cameraTranslation * float(time - inputTimePrev);
+  cameraRotationSum += cameraRotation * float(time - inputTimePrev);
+  inputSumSeconds += time - inputTimePrev;
+  inputTimePrev = time;
+}
+
 void SplatTestApp::update() {
-  if (spaceNav) {
-    spaceNav->update();
+  pollInput();
+
+  vec3 translation = cameraTranslation, rotation = cameraRotation;
+  if (inputSumSeconds > 0.0) {
+    translation = cameraTranslationSum / float(inputSumSeconds);
+    rotation = cameraRotationSum / float(inputSumSeconds);
+  }
+  cameraTranslationSum = cameraRotationSum = vec3(0.0f);
+  inputSumSeconds = 0.0;
+
+  if (checkpointWriter && checkpointWriter->isDone()) {
+    auto &error = checkpointWriter->error;
+    checkpointStatus = error.empty() ? "Saved " + checkpointWriter->path.string() : error;
+    checkpointWriter.reset();
+  }
+
+  double frameTime = getElapsedSeconds();
+  double frameSeconds = frameTime - frameTimePrev;
+  frameTimePrev = frameTime;
+
+  if (replayReader) {
+    updateReplay(frameSeconds);
+    updateGui();
+    return;
   }
 
-  {
-    const auto &ori = cameraBody.orientation;
-    cameraBody.impulse = glm::rotate(ori, cameraTranslation * vec3(1, 1, -1)) * 0.000005f;
-    cameraBody.angularImpulse = quat(cameraRotation * vec3(1, 1, -1) * 0.00000333f);
+  if (recordPending) {
+    recordPending = false;
+    startRecording();
   }
 
-  cameraBody.step();
-  cameraBody.applyTransform(camera);
+  try {
+    if (particleSys->swapUpdateShader()) {
+      updateShaderError.clear();
+      replayFrame.flags |= ReplayFrame::kShaderReload;
+    }
+  } catch (const gl::GlslProgExc &exc) {
+    updateShaderError = exc.what();
+  }
+
+  if (governor->enabled) applyQuality(governor->settings);
+  governor->beginStage(QualityGovernor::kStageSimulation);
+
+  frameTickCount = timestep.beginFrame(frameSeconds);
+  replayTicks.clear();
+
+  // NOTE(ryan): The camera body steps with the simulation, its friction and impulses are per step.
+  for (int i = 0; i < frameTickCount; ++i) {
+    timestep.tick();
+
+    getCameraImpulses(translation, rotation, cameraBody.impulse, cameraBody.angularImpulse);
+    cameraBody.step();
+    cameraBody.applyTransform(camera);
+
+    ReplayTick tick = {float(timestep.time), timestep.tickId, cameraBody.position,
+                       cameraBody.position - cameraBody.positionPrev, camera.getViewDirection()};
+    particleSys->update(tick.time, tick.tickId, tick.eyePos, tick.eyeVel, tick.viewDir);
+    if (replayWriter) replayTicks.push_back(tick);
+  }
 
-  particleSys->update(getElapsedSeconds(), getElapsedFrames(), cameraBody.position,
-                      cameraBody.position - cameraBody.positionPrev, camera.getViewDirection());
+  governor->beginStage(QualityGovernor::kStageSort);
+
+  float alpha = timestep.getAlpha();
+  cameraBody.applyTransform(camera, alpha);
+  particleSys->prepareDraw(alpha, camera.getEyePoint(), camera.getViewDirection());
+
+  replayFrame.alpha = alpha;
+  replayFrame.eyePos = camera.getEyePoint();
+  replayFrame.viewDir = camera.getViewDirection();
 
   updateGui();
 }
 
+fs::path SplatTestApp::getCheckpointPath() {
+  auto path = getAppPath().parent_path() / "checkpoints";
+  if (!fs::exists(path)) fs::create_directories(path);
+  return path / "particles.splatchk";
+}
+
+fs::path SplatTestApp::getTrajectoryCachePath() {
+  auto path = getAppPath().parent_path() / "caches";
+  if (!fs::exists(path)) fs::create_directories(path);
+  return path / "trajectory.splattraj";
+}
+
+fs::path SplatTestApp::getRecordingsPath() {
+  auto path = getAppPath().parent_path() / "recordings";
+  if (!fs::exists(path)) fs::create_directories(path);
+  return path;
+}
+
+// NOTE(ryan): Recordings start from an empty simulation at time zero, with a shader reload on the
+// first frame so the replay starts on the update shader as it is on disk. Called at the top of
+// update(), so the first frame recorded is a whole one.
+void SplatTestApp::startRecording() {
+  particleSys->reset();
+  timestep.accumulator = timestep.time = 0.0;
+  timestep.tickId = 0;
+
+  auto path = getRecordingsPath() / "recording.splatrec";
+  replayWriter = std::make_shared<ReplayWriter>(path, timestep.tickRate);
+  replayFrame = {};
+  replayFrame.flags = ReplayFrame::kShaderReload;
+  replayStatus = "Recording to " + path.string();
+}
+
+// NOTE(ryan): Replays run as fast as they can, with quality adaptation off, so frame times compare
+// between builds.
+void SplatTestApp::startReplay() {
+  auto path = getRecordingsPath() / "recording.splatrec";
+  try {
+    replayReader = std::make_shared<ReplayReader>(path);
+  } catch (const std::exception &exc) {
+    replayStatus = exc.what();
+    return;
+  }
+
+  particleSys->reset();
+  governor->enabled = false;
+  governor->reset();
+  applyQuality(governor->settings);
+
+  // Carry on at the recording's rate from where it leaves off.
+  timestep.tickRate = replayReader->tickRate;
+  timestep.tickSeconds = 1.0 / timestep.tickRate;
+  timestep.accumulator = 0.0;
+
+  replayStats = ReplayStats();
+  replayStatus = "Replaying " + path.string();
+  gl::enableVerticalSync(false);
+  disableFrameRate();
+}
+
+void SplatTestApp::stopReplay() {
+  auto csvPath = getRecordingsPath() / "replay_times.csv";
+  replayStats.report(csvPath);
+  replayStatus = "Replayed " + std::to_string(replayReader->frameIndex) + " frames, times in " +
+                 csvPath.string();
+  replayReader.reset();
+
+  gl::enableVerticalSync(true);
+  setFrameRate(60.0f);
+}
+
+void SplatTestApp::updateReplay(double frameSeconds) {
+  // frameSeconds is how long the last replay frame took. Before the first, it includes the reset.
+  uint32_t framesDone = replayReader->frameIndex;
+  if (framesDone > 0) {
+    replayStats.setFrame(framesDone - 1, float(frameSeconds * 1000.0));
+
+    if (governor->timedFrameId >= replayFirstFrameId) {
+      float gpuMs = 0.0f;
+      for (auto ms : governor->stageMilliseconds) gpuMs += ms;
+      replayStats.setGpu(governor->timedFrameId - replayFirstFrameId, gpuMs);
+    }
+  }
+
+  if (!replayReader->readFrame(replayFrame, replayTicks)) {
+    stopReplay();
+    return;
+  }
+  if (framesDone == 0) replayFirstFrameId = governor->frameId;
+
+  if (replayFrame.flags & ReplayFrame::kShaderReload) {
+    try {
+      particleSys->reloadUpdateShader(particleUpdateMainFilepath);
+      updateShaderError.clear();
+    } catch (const gl::GlslProgExc &exc) {
+      updateShaderError = exc.what();
+    }
+  }
+
+  governor->beginStage(QualityGovernor::kStageSimulation);
+  for (const auto &tick : replayTicks) {
+    particleSys->update(tick.time, tick.tickId, tick.eyePos, tick.eyeVel, tick.viewDir);
+    timestep.time = tick.time;
+    timestep.tickId = tick.tickId;
+  }
+  frameTickCount = int(replayTicks.size());
+
+  governor->beginStage(QualityGovernor::kStageSort);
+  particleSys->prepareDraw(replayFrame.alpha, replayFrame.eyePos, replayFrame.viewDir);
+}
+
+void SplatTestApp::getCameraImpulses(const vec3 &translation, const vec3 &rotation,
+                                     vec3 &impulse, quat &angularImpulse) const {
+  const auto &ori = cameraBody.orientation;
+  impulse = glm::rotate(ori, translation * vec3(1, 1, -1)) * 0.000005f;
+  angularImpulse = quat(rotation * vec3(1, 1, -1) * 0.00000333f);
+}
+
+// NOTE(ryan): The simulation ran with a camera interpolated a tick behind, from input polled before
+// the whole update. For drawing, drain the 3D mouse again and extrapolate the body to the present
+// with that input, then write it to the camera constants right before anything is drawn.
+void SplatTestApp::latchCamera() {
+  drawCamera = camera;
+
+  if (replayReader) {
+    drawCamera.setEyePoint(replayFrame.drawEyePos);
+    drawCamera.setOrientation(replayFrame.drawOrientation);
+    cameraConstants->update(drawCamera);
+    return;
+  }
+
+  if (!lateLatchEnabled) {
+    cameraConstants->update(drawCamera);
+    return;
+  }
+
+  // The samples stay integrated for the next update's ticks, only the latest is used here.
+  pollInput();
+
+  vec3 impulse;
+  quat angularImpulse;
+  getCameraImpulses(cameraTranslation, cameraRotation, impulse, angularImpulse);
+
+  // In steps past the last one, the time banked by the timestep plus however long update took.
+  double sinceStep = timestep.accumulator + (getElapsedSeconds() - frameTimePrev);
+  float t = timestep.tickSeconds > 0.0 ? float(sinceStep / timestep.tickSeconds) : 0.0f;
+
+  vec3 pos;
+  quat ori;
+  cameraBody.extrapolate(glm::clamp(t, 0.0f, 1.0f), impulse, angularImpulse, pos, ori);
+  drawCamera.setEyePoint(pos);
+  drawCamera.setOrientation(ori);
+
+  cameraConstants->update(drawCamera);
+}
+
+void SplatTestApp::recordFrame() {
+  replayFrame.drawEyePos = drawCamera.getEyePoint();
+  replayFrame.drawOrientation = drawCamera.getOrientation();
+  replayWriter->writeFrame(replayFrame, replayTicks);
+  replayFrame = {};
+}
+
+void SplatTestApp::applyQuality(const QualityGovernor::Settings &settings) {
+  auto &emitters = *particleSys->emitters;
+  emitters.maxAlive = uint32_t(settings.particleFraction * emitters.maxParticles);
+  particleSys->densityInterval = settings.densityInterval;
+  particleSys->particleDownsample = settings.downsample;
+  particleSys->pointSizeScale = settings.pointSizeScale;
+}
+
 
 void SplatTestApp::updateGui() {
   ui::NewFrame();
@@ -125,23 +433,271 @@ void SplatTestApp::updateGui() {
 
   if (ui::CollapsingHeader("Display")) {
     ui::Checkbox("Render Debug Graphics", &renderDebugGraphics);
+    if (renderDebugGraphics) {
+      ui::Checkbox("Overdraw Heatmap", &renderOverdraw);
+      if (auto heatmap = particleSys->overdrawHeatmap) {
+        ui::SliderFloat("Heatmap Max", &heatmap->heatmapMax, 1.0f, 1024.0f);
+        ui::Text("Fragments: %llu, avg depth %.2f, p99 %u, max %u",
+                 static_cast<unsigned long long>(heatmap->totalFragments),
+                 heatmap->averageDepthComplexity, heatmap->percentile99, heatmap->maxCount);
+      }
+    }
+    ui::Checkbox("Compute Rasteriser", &particleSys->computeRasterEnabled);
+    ui::Checkbox("Billboards", &particleSys->billboardsEnabled);
+    ui::SliderFloat("Min Point Size", &particleSys->minPointSize, 0.5f, 4.0f);
+    ui::SliderFloat("Max Point Size", &particleSys->maxPointSize, 16.0f, 1024.0f);
+
+    ui::TextUnformatted("Particle Resolution");
+    ui::RadioButton("Full", &particleSys->particleDownsample, 1);
+    ui::SameLine();
+    ui::RadioButton("Half", &particleSys->particleDownsample, 2);
+    ui::SameLine();
+    ui::RadioButton("Quarter", &particleSys->particleDownsample, 4);
+    if (auto target = particleSys->particleTarget) {
+      ui::SliderFloat("Upsample Depth Tolerance", &target->depthTolerance, 0.001f, 0.2f);
+    }
+
+    ui::Checkbox("Raymarch LOD", &particleSys->lodEnabled);
+    ui::SliderFloat("LOD Distance", &particleSys->lodDistance, 0.5f, 10.0f);
+    if (auto volume = particleSys->volumeRenderer) {
+      ui::SliderFloat("Volume Density Scale", &volume->densityScale, 0.0f, 4.0f);
+    }
+  }
+
+  if (ui::CollapsingHeader("Quality")) {
+    if (ui::Checkbox("Quality Governor", &governor->enabled) && !governor->enabled) {
+      governor->reset();
+      applyQuality(governor->settings);
+    }
+    ui::SliderFloat("Target GPU ms", &governor->targetMilliseconds, 4.0f, 33.0f);
+    ui::Text("GPU: %.2fms (simulation %.2f, sort %.2f, draw %.2f)", governor->smoothedMilliseconds,
+             governor->stageMilliseconds[QualityGovernor::kStageSimulation],
+             governor->stageMilliseconds[QualityGovernor::kStageSort],
+             governor->stageMilliseconds[QualityGovernor::kStageDraw]);
+    ui::TextUnformatted(governor->lastDecision.c_str());
+  }
+
+  if (ui::CollapsingHeader("Record / Replay")) {
+    if (replayReader) {
+      ui::Text("Replaying frame %u", replayReader->frameIndex);
+      if (ui::Button("Stop Replay")) stopReplay();
+    } else if (replayWriter) {
+      if (ui::Button("Stop Recording")) {
+        replayWriter.reset();
+        replayStatus.clear();
+      }
+    } else {
+      if (ui::Button("Record")) recordPending = true;
+      ui::SameLine();
+      if (ui::Button("Replay")) startReplay();
+    }
+    if (!replayStatus.empty()) ui::TextUnformatted(replayStatus.c_str());
+  }
+
+  if (ui::CollapsingHeader("Checkpoint")) {
+    if (checkpointWriter) {
+      ui::Text("Saving...");
+    } else if (ui::Button("Save")) {
+      checkpointWriter = std::make_shared<CheckpointWriter>(*particleSys, getCheckpointPath());
+    }
+    ui::SameLine();
+    if (ui::Button("Restore") && !replayReader) {
+      try {
+        restoreCheckpoint(*particleSys, getCheckpointPath());
+        checkpointStatus = "Restored " + getCheckpointPath().string();
+      } catch (const std::exception &exc) {
+        checkpointStatus = exc.what();
+      }
+    }
+    if (!checkpointStatus.empty()) ui::TextUnformatted(checkpointStatus.c_str());
+  }
+
+  if (ui::CollapsingHeader("Trajectory Cache")) {
+    if (auto &baker = particleSys->trajectoryBaker) {
+      ui::Text("%u frames, %.1f MB, %u stalls", uint32_t(baker->frameCount),
+               baker->byteCount / (1024.0 * 1024.0), baker->stallCount);
+      if (ui::Button("Stop Bake")) {
+        trajectoryStatus = "Baked " + baker->path.string();
+        baker = nullptr;
+      }
+    } else if (auto &player = particleSys->trajectoryPlayer) {
+      int frame = int(player->frame);
+      if (ui::SliderInt("Frame", &frame, 0, int(player->frameCount) - 1)) {
+        player->seek(uint32_t(frame));
+      }
+      ui::Text("%u stalls", player->stallCount);
+      if (player->corrupt) ui::TextUnformatted("Cache is corrupt, playback stopped");
+      if (ui::Button("Stop Playback")) particleSys->stopPlayback();
+    } else {
+      try {
+        if (ui::Button("Bake")) {
+          particleSys->startBake(getTrajectoryCachePath(), timestep.tickRate);
+          trajectoryStatus.clear();
+        }
+        ui::SameLine();
+        if (ui::Button("Play")) {
+          particleSys->startPlayback(getTrajectoryCachePath());
+          timestep.tickRate = particleSys->trajectoryPlayer->tickRate;
+          trajectoryStatus.clear();
+        }
+      } catch (const std::exception &exc) {
+        trajectoryStatus = exc.what();
+      }
+    }
+    if (!trajectoryStatus.empty()) ui::TextUnformatted(trajectoryStatus.c_str());
+  }
+
+  if (ui::CollapsingHeader("Point Cloud")) {
+    ui::InputText("Path", importPath, sizeof(importPath));
+    ui::Checkbox("Downsample To Capacity", &importDownsample);
+    ui::SliderFloat("Point Scale", &importPointScale, 0.5f, 4.0f);
+
+    if (auto &import = particleSys->pointCloudImport) {
+      ui::Text("Importing %u of %llu points, %.0f%%", import->importCount,
+               (unsigned long long)import->pointCount, import->getProgress() * 100.0f);
+    } else if (ui::Button("Import")) {
+      try {
+        particleSys->startImport(importPath, importDownsample, importPointScale);
+        importStatus.clear();
+      } catch (const std::exception &exc) {
+        importStatus = exc.what();
+      }
+    }
+    if (!importStatus.empty()) ui::TextUnformatted(importStatus.c_str());
+  }
+
+  if (ui::CollapsingHeader("Force Fields")) {
+    auto &forceFields = *particleSys->forceFields;
+    auto &fields = forceFields.fields;
+
+    ForceField field = {};
+    if (ui::Button("Attractor")) {
+      field.type = ForceField::kAttractor;
+      field.strength = 0.0005f;
+      field.radius = 0.5f;
+      fields.push_back(field);
+    }
+    ui::SameLine();
+    if (ui::Button("Vortex")) {
+      field.type = ForceField::kVortex;
+      field.position = vec3(0.0f, -1.0f, 0.0f);
+      field.axis = vec3(0.0f, 2.0f, 0.0f);
+      field.strength = 0.0005f;
+      field.radius = 0.6f;
+      fields.push_back(field);
+    }
+    ui::SameLine();
+    if (ui::Button("Floor")) {
+      field.type = ForceField::kPlane;
+      field.position = vec3(0.0f, -0.9f, 0.0f);
+      field.axis = vec3(0.0f, 1.0f, 0.0f);
+      field.strength = 0.1f;
+      field.radius = 0.05f;
+      fields.push_back(field);
+    }
+    ui::SameLine();
+    if (ui::Button("Torus Collider")) {
+      try {
+        field.type = ForceField::kSdf;
+        field.volume = forceFields.bakeSdf(
+            AxisAlignedBox(vec3(-1.0f, -0.4f, -1.0f), vec3(1.0f, 0.4f, 1.0f)), [](const vec3 &p) {
+              return glm::length(vec2(glm::length(vec2(p.x, p.z)) - 0.7f, p.y)) - 0.15f;
+            });
+        field.strength = 0.1f;
+        field.radius = 0.05f;
+        fields.push_back(field);
+        forceFieldStatus.clear();
+      } catch (const std::exception &exc) {
+        forceFieldStatus = exc.what();
+      }
+    }
+    if (!forceFieldStatus.empty()) ui::TextUnformatted(forceFieldStatus.c_str());
+    if (fields.size() > ForceFields::kMaxFields) {
+      ui::Text("Only the first %u fields apply", ForceFields::kMaxFields);
+    }
+
+    static const char *kTypeNames[] = {"Attractor", "Vortex", "Plane", "SDF"};
+    for (size_t i = 0; i < fields.size(); ++i) {
+      auto &f = fields[i];
+      ui::PushID(int(i));
+      ui::Separator();
+      ui::Text("%s %u", kTypeNames[f.type], uint32_t(i));
+      if (f.type != ForceField::kSdf) ui::DragFloat3("Position", &f.position.x, 0.01f);
+      if (f.type == ForceField::kVortex || f.type == ForceField::kPlane) {
+        ui::DragFloat3("Axis", &f.axis.x, 0.01f);
+        // Plane normals have to stay unit length.
+        if (f.type == ForceField::kPlane && glm::length(f.axis) > 0.0f) {
+          f.axis = glm::normalize(f.axis);
+        }
+      }
+      ui::DragFloat("Strength", &f.strength, 0.0001f, -1.0f, 1.0f);
+      ui::DragFloat("Radius", &f.radius, 0.01f, 0.0f, 4.0f);
+      bool remove = ui::Button("Remove");
+      ui::PopID();
+      if (remove) {
+        fields.erase(fields.begin() + i);
+        break;
+      }
+    }
+  }
+
+  if (ui::CollapsingHeader("Simulation")) {
+    ui::Checkbox("Fixed Timestep", &timestep.enabled);
+    ui::SliderFloat("Tick Rate", &timestep.tickRate, 10.0f, 240.0f);
+    ui::SliderInt("Max Ticks Per Frame", &timestep.maxTicksPerFrame, 1, 8);
+    ui::Text("Ticks this frame: %d", frameTickCount);
+    ui::Checkbox("Late Latch Camera", &lateLatchEnabled);
+
+    ui::Checkbox("Dynamic Bounds", &particleSys->dynamicBoundsEnabled);
+    if (auto fitter = particleSys->boundsFitter) {
+      ui::SliderFloat("Bounds Margin", &fitter->margin, 0.0f, 0.5f);
+      ui::SliderFloat("Bounds Shrink Threshold", &fitter->shrinkThreshold, 0.1f, 0.9f);
+    }
+
+    ui::Checkbox("Baked Noise Field", &particleSys->noiseFieldEnabled);
+    ui::Checkbox("Neighbour Grid", &particleSys->neighbourGridEnabled);
+    ui::SliderFloat("Grid Cell Size", &particleSys->neighbourGridCellSize, 0.02f, 0.5f);
+
+    ui::Checkbox("Density Cascades", &particleSys->cascadesEnabled);
+    ui::SliderInt("Cascade Count", &particleSys->cascadeCount, 2, DensityCascades::kMaxCascades);
+
+    ui::Checkbox("Fluid", &particleSys->fluidEnabled);
+    if (auto fluid = particleSys->fluidSolver) {
+      ui::SliderInt("Pressure Iterations", &fluid->iterations, 1, 200);
+      ui::SliderFloat("FLIP Ratio", &fluid->flipRatio, 0.0f, 1.0f);
+      ui::Text("Fluid solve: %.2fms, residual %.3g", fluid->solveMilliseconds, fluid->residual);
+    }
+
+    ui::Checkbox("Emitting", &particleSys->emitters->spawning);
+    auto &emitters = particleSys->emitters->emitters;
+    for (size_t i = 0; i < emitters.size(); ++i) {
+      auto label = "Emitter " + std::to_string(i) + " Rate";
+      ui::DragFloat(label.c_str(), &emitters[i].rate, 100.0f, 0.0f, 1e6f);
+    }
   }
 
   if (ui::CollapsingHeader("Shader Status")) {
-    if (updateShaderError.empty()) {
+    if (particleSys->isUpdateShaderPending()) {
+      ui::TextUnformatted("Compiling...");
+    } else if (updateShaderError.empty()) {
       ui::TextUnformatted("Compile Successful");
     } else {
       ui::TextUnformatted(updateShaderError.c_str());
     }
+    ui::Text("Program cache: %u hits, %u misses, %.2fs compiling", programCache->hitCount.load(),
+             programCache->missCount.load(), programCache->getCompileSeconds());
+    ui::Text("Upload ring: %.0f%% of %uKB, peak %uKB, %u overflows",
+             uploadRing->getOccupancy() * 100.0f, uint32_t(uploadRing->getRegionSize() >> 10),
+             uint32_t(uploadRing->peakFrameBytes >> 10), uploadRing->overflowCount);
+    ui::Text("Upload ring stalls: %u, %.2fms", uploadRing->stallCount,
+             uploadRing->stallSeconds * 1000.0);
   }
 }
 
 
-void SplatTestApp::draw() {
+void SplatTestApp::drawScene() {
   gl::clear(Color(0.0f, 0.0f, 0.0f));
 
-  gl::setMatrices(camera);
-
   if (renderDebugGraphics) {
     gl::enableDepth();
     gl::disableAlphaBlending();
@@ -150,13 +706,56 @@ void SplatTestApp::draw() {
     gl::drawStrokedCube(particleSys->volumeBounds);
     gl::drawCoordinateFrame(0.25f, 0.05f, 0.01f);
   }
+}
+
+void SplatTestApp::draw() {
+  governor->beginStage(QualityGovernor::kStageDraw);
+
+  latchCamera();
+  if (replayWriter) recordFrame();
+  gl::setMatrices(drawCamera);
+
+  // NOTE(ryan): Reduced resolution particles are upsampled against the scene depth, so in that case
+  // the scene goes through an FBO first.
+  gl::Texture2dRef sceneDepth;
+  if (particleSys->particleDownsample > 1) {
+    if (!sceneFbo || sceneFbo->getSize() != getWindowSize()) {
+      sceneFbo = gl::Fbo::create(getWindowWidth(), getWindowHeight(),
+                                 gl::Fbo::Format().depthTexture());
+    }
+
+    {
+      gl::ScopedFramebuffer scopedFbo(sceneFbo);
+      drawScene();
+    }
+
+    {
+      gl::ScopedMatrices scopedMatrices;
+      gl::ScopedBlend scopedBlend(false);
+      gl::ScopedDepth scopedDepth(false);
+      gl::setMatricesWindow(getWindowSize());
+      gl::draw(sceneFbo->getColorTexture(), Rectf(vec2(0.0f), vec2(getWindowSize())));
+    }
+
+    sceneDepth = sceneFbo->getDepthTexture();
+  } else {
+    drawScene();
+  }
 
   gl::enableDepthRead();
   gl::disableDepthWrite();
   gl::enableAlphaBlendingPremult();
   gl::enable(GL_PROGRAM_POINT_SIZE);
 
-  particleSys->draw(getWindowHeight() / 100.0f);
+  float pointSize = getWindowHeight() / 100.0f;
+  particleSys->draw(pointSize, sceneDepth);
+
+  if (renderDebugGraphics && renderOverdraw) {
+    particleSys->drawOverdraw(pointSize);
+  }
+
+  uploadRing->endFrame();
+  governor->endFrame();
 
   if (!isFullScreen()) {
     ui::Render();
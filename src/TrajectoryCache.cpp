@@ -0,0 +1,427 @@
+#include "TrajectoryCache.hpp"
+
+#include "cinder/Log.h"
+#include "cinder/Thread.h"
+#include "cinder/app/App.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace splat {
+
+namespace {
+
+const uint32_t kMagic = 0x43545053; // "SPTC"
+const uint32_t kVersion = 1;
+
+const uint32_t kChunkFrames = 32;
+// Mirrors kTrajectoryLaneCount in utils/trajectory_frame.glsl.
+const uint32_t kLaneCount = 8;
+const GLuint kFrameBinding = 18;
+
+struct FileHeader {
+  uint32_t magic, version;
+  uint32_t particleCount, frameCount;
+  uint32_t chunkFrames;
+  float tickRate;
+  vec3 boundsMin, boundsMax;
+  // Where the chunk offsets are. Zero until the baker finishes the file.
+  uint64_t indexOffset;
+};
+
+void sleepBriefly() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+GLuint createSlotBuffer(GLsizeiptr size, GLbitfield flags, void **mappedPtr) {
+  GLuint buffer = 0;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+  glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, flags);
+  *mappedPtr = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, flags);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  return buffer;
+}
+
+void deleteSlotBuffer(GLuint buffer) {
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+  glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  glDeleteBuffers(1, &buffer);
+}
+
+void waitFence(GLsync fence) {
+  while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+  }
+  glDeleteSync(fence);
+}
+
+void putVarint(std::vector<uint8_t> &out, uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back(uint8_t(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(uint8_t(value));
+}
+
+bool getVarint(const uint8_t *data, size_t size, size_t &pos, uint32_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 32 && pos < size; shift += 7) {
+    uint8_t byte = data[pos++];
+    value |= uint32_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+// NOTE(ryan): Each lane is stored as the zigzagged difference from the previous frame's, as a
+// varint. A zero byte can't start a non-zero varint, so it marks a run of unchanged lanes and is
+// followed by the run length. Dead and resting particles cost next to nothing this way.
+void encodeFrame(const uint16_t *frame, const uint16_t *prev, size_t count,
+                 std::vector<uint8_t> &out) {
+  out.clear();
+  for (size_t i = 0; i < count;) {
+    auto delta = int16_t(uint16_t(frame[i] - prev[i]));
+    auto zigzag = uint16_t((delta << 1) ^ (delta >> 15));
+
+    if (zigzag == 0) {
+      size_t run = 1;
+      while (i + run < count && frame[i + run] == prev[i + run]) ++run;
+      out.push_back(0);
+      putVarint(out, uint32_t(run));
+      i += run;
+    } else {
+      putVarint(out, zigzag);
+      ++i;
+    }
+  }
+}
+
+// Applies an encoded frame on top of the previous one in place. False if it's malformed.
+bool decodeFrame(const uint8_t *data, size_t size, uint16_t *frame, size_t count) {
+  size_t pos = 0;
+  for (size_t i = 0; i < count;) {
+    if (pos >= size) return false;
+
+    uint32_t value;
+    if (data[pos] == 0) {
+      ++pos;
+      if (!getVarint(data, size, pos, value) || value == 0 || value > count - i) return false;
+      i += value;
+    } else {
+      if (!getVarint(data, size, pos, value) || value > 0xffff) return false;
+      auto delta = int16_t((value >> 1) ^ (0u - (value & 1)));
+      frame[i] = uint16_t(frame[i] + delta);
+      ++i;
+    }
+  }
+  return pos == size;
+}
+
+} // anonymous
+
+
+TrajectoryBaker::TrajectoryBaker(const ProgramCacheRef &programCache, const fs::path &path,
+                                 uint32_t particleCount, uint32_t workGroupSize,
+                                 const AxisAlignedBox &bounds, float tickRate)
+: particleCount(particleCount), workGroupSize(workGroupSize), path(path), tickRate(tickRate) {
+  boundsMin = bounds.getMin();
+  boundsSize = bounds.getSize();
+
+  quantizeProg = programCache->createCompute(
+      ComputeProg::Format()
+          .compute(app::getAssetPath("trajectory_quantize_cs.glsl"))
+          .define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize))
+          .define("PARTICLE_COUNT", std::to_string(particleCount) + "u"));
+
+  file.open(path.string(), std::ios::binary | std::ios::trunc);
+  if (!file) throw std::runtime_error("Can't create trajectory cache " + path.string());
+
+  // Written again with the frame count and index once the bake is done.
+  FileHeader header = {};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  const size_t laneCount = size_t(particleCount) * kLaneCount;
+  prevFrame.resize(laneCount);
+
+  const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT;
+  for (int i = 0; i < kSlotCount; ++i) {
+    void *ptr;
+    slotBuffers[i] = createSlotBuffer(laneCount * sizeof(uint16_t), flags, &ptr);
+    slotPtrs[i] = static_cast<const uint16_t *>(ptr);
+    slotFences[i] = nullptr;
+    slotBusy[i] = false;
+  }
+
+  encodeThread = std::thread(&TrajectoryBaker::encodeThreadFn, this);
+}
+
+TrajectoryBaker::~TrajectoryBaker() {
+  retireSlots(true);
+  encodeStop = true;
+  encodeThread.join();
+
+  FileHeader header = {kMagic, kVersion, particleCount, frameCount, kChunkFrames, tickRate,
+                       boundsMin, boundsMin + boundsSize, uint64_t(file.tellp())};
+  file.write(reinterpret_cast<const char *>(chunkOffsets.data()),
+             chunkOffsets.size() * sizeof(uint64_t));
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.close();
+
+  if (file) {
+    CI_LOG_I("Baked " << header.frameCount << " frames to " << path);
+  } else {
+    CI_LOG_E("Failed to write trajectory cache " << path);
+  }
+
+  for (auto buffer : slotBuffers) deleteSlotBuffer(buffer);
+}
+
+void TrajectoryBaker::retireSlots(bool wait) {
+  while (auto &fence = slotFences[retireSlot]) {
+    if (wait) {
+      waitFence(fence);
+    } else if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+      break;
+    } else {
+      glDeleteSync(fence);
+    }
+    fence = nullptr;
+
+    encodeQueue.push(retireSlot);
+    retireSlot = (retireSlot + 1) % kSlotCount;
+  }
+}
+
+void TrajectoryBaker::capture(const gl::SsboRef &particles) {
+  retireSlots(false);
+
+  // Baking is offline, so rather than drop a frame this waits for the encoder.
+  if (slotBusy[captureSlot]) {
+    ++stallCount;
+    retireSlots(true);
+    while (slotBusy[captureSlot]) sleepBriefly();
+  }
+
+  quantizeProg->bind();
+  quantizeProg->uniform("trajectoryBoundsMin", boundsMin);
+  quantizeProg->uniform("trajectoryBoundsSize", boundsSize);
+
+  particles->bindBase(0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kFrameBinding, slotBuffers[captureSlot]);
+
+  glDispatchCompute((particleCount / 2 + workGroupSize - 1) / workGroupSize, 1, 1);
+  glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kFrameBinding, 0);
+  particles->unbindBase();
+
+  slotBusy[captureSlot] = true;
+  slotFences[captureSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+  captureSlot = (captureSlot + 1) % kSlotCount;
+}
+
+void TrajectoryBaker::encodeThreadFn() {
+  ThreadSetup threadSetup;
+
+  while (true) {
+    // Read before popping, so nothing pushed before the stop is missed.
+    bool stop = encodeStop;
+
+    int slot;
+    if (!encodeQueue.pop(slot)) {
+      if (stop) break;
+      sleepBriefly();
+      continue;
+    }
+
+    if (frameCount % kChunkFrames == 0) {
+      chunkOffsets.push_back(uint64_t(file.tellp()));
+      std::fill(prevFrame.begin(), prevFrame.end(), uint16_t(0));
+    }
+
+    const uint16_t *frame = slotPtrs[slot];
+    encodeFrame(frame, prevFrame.data(), prevFrame.size(), encoded);
+    std::memcpy(prevFrame.data(), frame, prevFrame.size() * sizeof(uint16_t));
+    slotBusy[slot] = false;
+
+    auto size = uint32_t(encoded.size());
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char *>(encoded.data()), size);
+
+    byteCount += sizeof(size) + size;
+    ++frameCount;
+  }
+}
+
+
+TrajectoryPlayer::TrajectoryPlayer(const ProgramCacheRef &programCache, const fs::path &path,
+                                   uint32_t particleCount, uint32_t workGroupSize)
+: particleCount(particleCount), workGroupSize(workGroupSize), path(path) {
+  file.open(path.string(), std::ios::binary);
+  if (!file) throw std::runtime_error("Can't open trajectory cache " + path.string());
+
+  FileHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != kMagic ||
+      header.version != kVersion) {
+    throw std::runtime_error("Not a version " + std::to_string(kVersion) + " trajectory cache");
+  }
+  if (header.particleCount != particleCount) {
+    throw std::runtime_error("Trajectory cache was baked with a different pool size");
+  }
+  if (header.indexOffset == 0 || header.frameCount == 0 || header.chunkFrames == 0) {
+    throw std::runtime_error("Trajectory cache is empty or wasn't finished");
+  }
+
+  bounds = AxisAlignedBox(header.boundsMin, header.boundsMax);
+  tickRate = header.tickRate;
+  frameCount = header.frameCount;
+  chunkFrames = header.chunkFrames;
+
+  chunkOffsets.resize((frameCount + chunkFrames - 1) / chunkFrames);
+  file.seekg(header.indexOffset);
+  if (!file.read(reinterpret_cast<char *>(chunkOffsets.data()),
+                 chunkOffsets.size() * sizeof(uint64_t))) {
+    throw std::runtime_error("Trajectory cache index is truncated");
+  }
+
+  dequantizeProg = programCache->createCompute(
+      ComputeProg::Format()
+          .compute(app::getAssetPath("trajectory_dequantize_cs.glsl"))
+          .define("WORK_GROUP_SIZE_X", std::to_string(workGroupSize))
+          .define("PARTICLE_COUNT", std::to_string(particleCount) + "u"));
+
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  for (int i = 0; i < kSlotCount; ++i) {
+    void *ptr;
+    slotBuffers[i] =
+        createSlotBuffer(size_t(particleCount) * kLaneCount * sizeof(uint16_t), flags, &ptr);
+    slotPtrs[i] = static_cast<uint16_t *>(ptr);
+    slotFences[i] = nullptr;
+    slotStates[i] = kSlotFree;
+  }
+
+  startDecode(0);
+}
+
+TrajectoryPlayer::~TrajectoryPlayer() {
+  stopDecode();
+  for (auto fence : slotFences) {
+    if (fence) glDeleteSync(fence);
+  }
+  for (auto buffer : slotBuffers) deleteSlotBuffer(buffer);
+}
+
+void TrajectoryPlayer::startDecode(uint32_t frame) {
+  decodeStop = false;
+  decodeThread = std::thread(&TrajectoryPlayer::decodeThreadFn, this, frame);
+}
+
+void TrajectoryPlayer::stopDecode() {
+  decodeStop = true;
+  if (decodeThread.joinable()) decodeThread.join();
+}
+
+void TrajectoryPlayer::seek(uint32_t frame) {
+  stopDecode();
+
+  // The slots are about to be written again, the GPU has to be done reading them.
+  for (int i = 0; i < kSlotCount; ++i) {
+    if (slotFences[i]) waitFence(slotFences[i]);
+    slotFences[i] = nullptr;
+    slotStates[i] = kSlotFree;
+  }
+  applySlot = decodeSlot = 0;
+  corrupt = false;
+
+  startDecode(std::min(frame, frameCount - 1));
+}
+
+void TrajectoryPlayer::apply(const gl::SsboRef &particles, const gl::SsboRef &particlesPrev,
+                             ParticleEmitters &emitters) {
+  for (int i = 0; i < kSlotCount; ++i) {
+    if (slotFences[i] && glClientWaitSync(slotFences[i], 0, 0) != GL_TIMEOUT_EXPIRED) {
+      glDeleteSync(slotFences[i]);
+      slotFences[i] = nullptr;
+      slotStates[i] = kSlotFree;
+    }
+  }
+
+  if (slotStates[applySlot] != kSlotFilled) {
+    ++stallCount;
+    return;
+  }
+
+  dequantizeProg->bind();
+  dequantizeProg->uniform("trajectoryBoundsMin", bounds.getMin());
+  dequantizeProg->uniform("trajectoryBoundsSize", bounds.getSize());
+
+  particles->bindBase(0);
+  particlesPrev->bindBase(1);
+  emitters.bindBuffers();
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kFrameBinding, slotBuffers[applySlot]);
+
+  glDispatchCompute((particleCount + workGroupSize - 1) / workGroupSize, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kFrameBinding, 0);
+  emitters.unbindBuffers();
+  particlesPrev->unbindBase();
+  particles->unbindBase();
+
+  emitters.finish();
+
+  slotFences[applySlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slotStates[applySlot] = kSlotInFlight;
+  frame = slotFrames[applySlot];
+  applySlot = (applySlot + 1) % kSlotCount;
+}
+
+void TrajectoryPlayer::decodeThreadFn(uint32_t startFrame) {
+  ThreadSetup threadSetup;
+
+  std::vector<uint16_t> frameLanes(size_t(particleCount) * kLaneCount);
+  std::vector<uint8_t> encoded;
+
+  // Starts from the chunk holding startFrame and decodes up to it without handing anything over.
+  uint32_t next = startFrame / chunkFrames * chunkFrames;
+
+  while (!decodeStop) {
+    if (next == frameCount) next = 0;
+
+    if (next % chunkFrames == 0) {
+      file.clear();
+      file.seekg(chunkOffsets[next / chunkFrames]);
+      std::fill(frameLanes.begin(), frameLanes.end(), uint16_t(0));
+    }
+
+    uint32_t size = 0;
+    file.read(reinterpret_cast<char *>(&size), sizeof(size));
+    encoded.resize(size);
+    if (!file || !file.read(reinterpret_cast<char *>(encoded.data()), size) ||
+        !decodeFrame(encoded.data(), size, frameLanes.data(), frameLanes.size())) {
+      CI_LOG_E("Trajectory cache " << path << " is corrupt at frame " << next);
+      corrupt = true;
+      return;
+    }
+
+    uint32_t decoded = next++;
+    if (decoded < startFrame) continue;
+    startFrame = 0;
+
+    while (slotStates[decodeSlot] != kSlotFree) {
+      if (decodeStop) return;
+      sleepBriefly();
+    }
+
+    std::memcpy(slotPtrs[decodeSlot], frameLanes.data(), frameLanes.size() * sizeof(uint16_t));
+    slotFrames[decodeSlot] = decoded;
+    slotStates[decodeSlot] = kSlotFilled;
+    decodeSlot = (decodeSlot + 1) % kSlotCount;
+  }
+}
+
+} // splat
@@ -0,0 +1,90 @@
+#include "UploadRing.hpp"
+
+#include "cinder/Timer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace splat {
+
+UploadRing::UploadRing(GLsizeiptr regionSize)
+: regionSize(regionSize), region(0), head(0), frameBytes(0) {
+  GLint alignment = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  uniformAlignment = alignment;
+  alignment = 256;
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  storageAlignment = alignment;
+
+  const GLsizeiptr size = regionSize * kRegionCount;
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+  mappedPtr = static_cast<uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  for (auto &fence : fences) fence = nullptr;
+}
+
+UploadRing::~UploadRing() {
+  for (auto fence : fences) {
+    if (fence) glDeleteSync(fence);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  glDeleteBuffers(1, &buffer);
+}
+
+void UploadRing::advance() {
+  fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region = (region + 1) % kRegionCount;
+  head = 0;
+
+  auto &fence = fences[region];
+  if (!fence) return;
+
+  if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+    Timer timer(true);
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+    }
+    ++stallCount;
+    stallSeconds += timer.getSeconds();
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+UploadRing::Allocation UploadRing::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+  if (size > regionSize) throw std::length_error("Upload is bigger than an UploadRing region");
+
+  GLsizeiptr offset = (head + alignment - 1) / alignment * alignment;
+  if (offset + size > regionSize) {
+    ++overflowCount;
+    advance();
+    offset = 0;
+  }
+  head = offset + size;
+  frameBytes += size;
+
+  offset += region * regionSize;
+  return {buffer, offset, size, mappedPtr + offset};
+}
+
+UploadRing::Allocation UploadRing::upload(const void *data, GLsizeiptr size,
+                                          GLsizeiptr alignment) {
+  auto allocation = allocate(size, alignment);
+  std::memcpy(allocation.ptr, data, size);
+  return allocation;
+}
+
+void UploadRing::endFrame() {
+  lastFrameBytes = frameBytes;
+  peakFrameBytes = std::max(peakFrameBytes, frameBytes);
+  frameBytes = 0;
+  advance();
+}
+
+} // splat
@@ -2,6 +2,7 @@
 
 #include "cinder/ImageIo.h"
 #include "cinder/Utilities.h"
+#include "cinder/gl/gl.h"
 
 #include "Watchdog.h"
 
@@ -20,6 +21,24 @@ int firstIndexOf(const std::string &str, char c) {
   return it - str.begin();
 }
 
+uint64_t hashFnv1a(const void *data, size_t size, uint64_t hash) {
+  auto bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+void drawOverViewport(const gl::Texture2dRef &texture) {
+  ivec2 size = gl::getViewport().second;
+
+  gl::ScopedMatrices scopedMatrices;
+  gl::ScopedDepth scopedDepth(false);
+  gl::setMatricesWindow(size);
+  gl::draw(texture, Rectf(vec2(0.0f), vec2(size)));
+}
+
 
 fs::path saveGrab(const Surface &surf, const fs::path &grabsDirPath) {
   const std::string prefix = "grab_";
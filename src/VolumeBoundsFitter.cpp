@@ -0,0 +1,106 @@
+#include "VolumeBoundsFitter.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+VolumeBoundsFitter::VolumeBoundsFitter(const ProgramCacheRef &programCache,
+                                       const AxisAlignedBox &initBounds, const uvec3 &volumeRes,
+                                       uint32_t workGroupSizeX)
+: readbackSlot(0), volumeRes(volumeRes), frameCount(0), bounds(initBounds) {
+  reduceProg = programCache->createCompute(
+      ComputeProg::Format()
+          .compute(app::getAssetPath("bounds_reduce_cs.glsl"))
+          .define("WORK_GROUP_SIZE_X", std::to_string(workGroupSizeX)));
+  fitProg = programCache->createCompute(
+      ComputeProg::Format().compute(app::getAssetPath("bounds_fit_cs.glsl")));
+
+  Bounds init = {};
+  init.worldToUnitVolumeMtx = glm::translate(glm::scale(vec3(1.0f) / vec3(initBounds.getSize())),
+                                             -initBounds.getMin());
+  init.worldToVolumeMtx = glm::scale(vec3(volumeRes)) * init.worldToUnitVolumeMtx;
+  init.boundsMin = vec4(initBounds.getMin(), 0.0f);
+  init.boundsMax = vec4(initBounds.getMax(), 0.0f);
+  init.reduceMin = uvec4(0xffffffff);
+  init.reduceMax = uvec4(0);
+  boundsBuffer = gl::Ssbo::create(sizeof(Bounds), &init, GL_DYNAMIC_COPY);
+
+  for (uint32_t i = 0; i < kReadbackCount; ++i) {
+    readbackBuffers[i] = gl::Ssbo::create(2 * sizeof(vec4), nullptr, GL_DYNAMIC_READ);
+    readbackFences[i] = nullptr;
+  }
+}
+
+VolumeBoundsFitter::~VolumeBoundsFitter() {
+  for (auto fence : readbackFences) {
+    if (fence) glDeleteSync(fence);
+  }
+}
+
+void VolumeBoundsFitter::apply(FrameConstants &frameConstants) const {
+  frameConstants.copyVolumeFrom(boundsBuffer->getId());
+}
+
+void VolumeBoundsFitter::fit(const gl::SsboRef &particles, const ParticleEmitters &emitters) {
+  if (frameCount++ % interval != 0) return;
+
+  reduceProg->bind();
+
+  particles->bindBase(0);
+  emitters.bindBuffers();
+  boundsBuffer->bindBase(kBinding);
+
+  emitters.dispatchAlive();
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  fitProg->bind();
+  fitProg->uniform("volumeRes", volumeRes);
+  fitProg->uniform("margin", margin);
+  fitProg->uniform("shrinkThreshold", shrinkThreshold);
+  fitProg->uniform("minSize", minSize);
+
+  glDispatchCompute(1, 1, 1);
+  // Read by the copies in apply() and below.
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  boundsBuffer->unbindBase();
+  emitters.unbindBuffers();
+  particles->unbindBase();
+
+  // NOTE(ryan): Copy out the bounds for the CPU, skipped if the readback slot is still in flight.
+  // readBounds() is polled separately so the caller sees every new fit.
+  if (!readbackFences[readbackSlot]) {
+    glBindBuffer(GL_COPY_READ_BUFFER, boundsBuffer->getId());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[readbackSlot]->getId());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                        offsetof(Bounds, boundsMin), 0, 2 * sizeof(vec4));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    readbackFences[readbackSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readbackSlot = (readbackSlot + 1) % kReadbackCount;
+  }
+}
+
+bool VolumeBoundsFitter::readBounds() {
+  auto &fence = readbackFences[readbackSlot];
+  if (!fence) return false;
+
+  if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+  glDeleteSync(fence);
+  fence = nullptr;
+
+  vec4 minMax[2];
+  readbackBuffers[readbackSlot]->bind();
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(minMax), minMax);
+  readbackBuffers[readbackSlot]->unbind();
+
+  AxisAlignedBox readback{vec3(minMax[0]), vec3(minMax[1])};
+  if (readback.getMin() == bounds.getMin() && readback.getMax() == bounds.getMax()) return false;
+
+  bounds = readback;
+  return true;
+}
+
+} // splat
@@ -0,0 +1,90 @@
+#include "VolumeRenderer.hpp"
+#include "FrameConstants.hpp"
+#include "Utils.hpp"
+
+#include "cinder/app/App.h"
+#include "cinder/gl/gl.h"
+
+namespace splat {
+
+static const uint32_t kBrickGroupSizeXYZ = 4;
+static const uint32_t kRaymarchGroupSizeXY = 8;
+
+
+VolumeRenderer::VolumeRenderer(const ProgramCacheRef &programCache, const uvec3 &volumeRes,
+                               uint32_t brickSize, int downsample)
+: volumeRes(volumeRes), brickSize(brickSize), downsample(downsample) {
+  brickProg = programCache->createCompute(
+      ComputeProg::Format().compute(app::getAssetPath("volume_bricks_cs.glsl")));
+  raymarchProg = programCache->createCompute(
+      ComputeProg::Format().compute(app::getAssetPath("volume_raymarch_cs.glsl")));
+  FrameConstants::verifyLayout(*raymarchProg, "volume_raymarch_cs.glsl");
+
+  {
+    uvec3 brickRes = (volumeRes + brickSize - 1u) / brickSize;
+    auto fmt = gl::Texture3d::Format()
+                   .immutableStorage()
+                   .internalFormat(GL_RG32UI)
+                   .minFilter(GL_NEAREST)
+                   .magFilter(GL_NEAREST);
+    fmt.setMaxMipmapLevel(0);
+    brickTexture = gl::Texture3d::create(brickRes.x, brickRes.y, brickRes.z, fmt);
+  }
+}
+
+void VolumeRenderer::updateBricks(const gl::Texture3dRef &densityTexture) {
+  brickProg->bind();
+  brickProg->uniform("brickSize", brickSize);
+
+  glBindImageTexture(0, densityTexture->getId(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
+  glBindImageTexture(1, brickTexture->getId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RG32UI);
+
+  auto groups = [](GLint size) {
+    return (GLuint(size) + kBrickGroupSizeXYZ - 1) / kBrickGroupSizeXYZ;
+  };
+  glDispatchCompute(groups(brickTexture->getWidth()), groups(brickTexture->getHeight()),
+                    groups(brickTexture->getDepth()));
+  // The raymarch reads the bricks with imageLoad.
+  glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+void VolumeRenderer::draw(const gl::Texture3dRef &densityTexture, float startDistance) {
+  ivec2 size = glm::max(gl::getViewport().second / downsample, ivec2(1));
+
+  if (!targetTexture || targetTexture->getSize() != size) {
+    auto fmt = gl::Texture2d::Format()
+                   .immutableStorage()
+                   .internalFormat(GL_RGBA16F)
+                   .minFilter(GL_LINEAR)
+                   .magFilter(GL_LINEAR);
+    targetTexture = gl::Texture2d::create(size.x, size.y, fmt);
+  }
+
+  mat4 viewMtx = gl::getViewMatrix();
+  mat4 clipToWorldMtx = glm::inverse(gl::getProjectionMatrix() * viewMtx);
+  vec3 cameraPos = vec3(glm::inverse(viewMtx)[3]);
+
+  {
+    raymarchProg->bind();
+    raymarchProg->uniform("brickSize", brickSize);
+    raymarchProg->uniform("clipToWorldMtx", clipToWorldMtx);
+    raymarchProg->uniform("cameraPos", cameraPos);
+    raymarchProg->uniform("startDistance", startDistance);
+    raymarchProg->uniform("densityScale", densityScale);
+    raymarchProg->uniform("volumeColor", color);
+
+    glBindImageTexture(0, targetTexture->getId(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glBindImageTexture(1, densityTexture->getId(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindImageTexture(2, brickTexture->getId(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_RG32UI);
+
+    glDispatchCompute((size.x + kRaymarchGroupSizeXY - 1) / kRaymarchGroupSizeXY,
+                      (size.y + kRaymarchGroupSizeXY - 1) / kRaymarchGroupSizeXY, 1);
+    // Sampled by the composite below, written again as an image next frame.
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+
+  // NOTE(ryan): The target is premultiplied, bilinear upsampling does the rest.
+  drawOverViewport(targetTexture);
+}
+
+} // splat